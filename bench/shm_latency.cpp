@@ -0,0 +1,93 @@
+// Cross-process latency of the shared-memory transport.
+//
+//   g++ -std=c++17 -O2 -I.. shm_latency.cpp -o shm_latency
+//   ./shm_latency [busy|futex] [count] [payload bytes] [gap us]
+//
+// A forked child sends count messages, each stamped with CLOCK_MONOTONIC,
+// gap microseconds apart; the parent gateway records one-way latency on
+// receipt and prints percentiles.  Needs at least two free cores: both sides
+// spin.
+//
+// The default gap is 5us for busy, and 1ms for futex: well past the
+// gateway's IDLE_SPINS budget, so every message finds it in FUTEX_WAIT and
+// what is measured is the wake path.  A futex run with a short gap never
+// sleeps and gives busy-poll numbers.
+
+#include "../shm_transport.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+
+using namespace FIX;
+
+static uint64_t now_ns()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+static void producer(ShmSegment const& seg, WaitMode mode, size_t count, size_t payload,
+                     uint64_t gap_ns)
+{
+  ShmProducer out(seg, mode);
+  std::string msg(std::max(payload, sizeof(uint64_t)), 'x');
+  for (size_t i = 0; i < count; ++i) {
+    uint64_t gap_end = now_ns() + gap_ns;  // measure latency, not queueing
+    while (now_ns() < gap_end) ;
+    uint64_t t = now_ns();
+    std::memcpy(&msg[0], &t, sizeof(t));
+    while (!out.send(msg)) ;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  WaitMode mode = argc > 1 && std::string(argv[1]) == "futex" ? WaitMode::Futex : WaitMode::BusyPoll;
+  bool futex = mode == WaitMode::Futex;
+  size_t count   = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : futex ? 20000 : 1000000;
+  size_t payload = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 200;  // about a NewOrder
+  uint64_t gap_us = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : futex ? 1000 : 5;
+
+  enum : size_t { RING_BYTES = 1 << 20 };
+  if (count == 0 || payload > RING_BYTES / 2 - sizeof(shm::RecordHeader)) {
+    std::fprintf(stderr, "count must be at least 1, payload at most %zu bytes\n",
+                 RING_BYTES / 2 - sizeof(shm::RecordHeader));
+    return 1;
+  }
+
+  ShmSegment seg = ShmSegment::create_anonymous(1, RING_BYTES);
+
+  pid_t pid = fork();
+  if (pid < 0) { perror("fork"); return 1; }
+  if (pid == 0) {
+    producer(seg, mode, count, payload, gap_us * 1000);
+    _exit(0);
+  }
+
+  std::vector<uint64_t> lat;
+  lat.reserve(count);
+  std::atomic<bool> stop(false);
+  ShmGateway gw(seg, mode);
+  gw.run([&](uint32_t, ShmRecord, std::string_view msg) {
+    uint64_t t;
+    std::memcpy(&t, msg.data(), sizeof(t));
+    lat.push_back(now_ns() - t);
+    if (lat.size() == count) stop = true;
+  }, stop);
+
+  waitpid(pid, nullptr, 0);
+
+  std::sort(lat.begin(), lat.end());
+  auto pct = [&](double p) { return lat[std::min(lat.size() - 1, size_t(p * lat.size()))]; };
+  std::printf("%s, %zu msgs of %zu bytes, %lu us apart, one-way ns: "
+              "min %lu p50 %lu p90 %lu p99 %lu p99.9 %lu max %lu\n",
+              futex ? "futex" : "busy-poll", lat.size(), payload, gap_us,
+              lat.front(), pct(0.5), pct(0.9), pct(0.99), pct(0.999), lat.back());
+  return 0;
+}
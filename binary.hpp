@@ -0,0 +1,462 @@
+#ifndef FIX_BINARY_HPP_
+#define FIX_BINARY_HPP_
+
+// Binary (SBE-style) codec for the same Message<>/Group<>/RepeatGroup<> types,
+// for IPC between our own processes.
+//
+// A message is a BinaryHeader followed by the root block, then variable data:
+//   - every field has a fixed offset in its block, computed at compile time
+//     from the field tuple;
+//   - a block starts with a presence bitmap, one bit per field (Optional<>s);
+//   - numbers are stored little endian in their natural width;
+//   - strings are {uint32 offset, uint32 length} into the variable data;
+//   - a RepeatGroup<> is {uint32 offset, uint32 count} pointing at count
+//     consecutive blocks of the group's own layout.
+// Offsets are relative to the start of the message (the header).
+// The header carries a fingerprint of the message's layout (tags, types,
+// optionality, groups), so a reader built from a different field list
+// rejects the message rather than misreading it.
+//
+// Usage:
+//   std::string buf;
+//   binary_encode(order, buf);
+//   BinaryMessage<NewOrder> v(buf.data(), buf.size());   // zero copy
+//   double qty = v.get<OrderQty>();
+//   std::string_view sec = v.get<SecurityId>();
+//   if (v.has<Optional<Price0>>()) px = v.get<Optional<Price0>>();
+//   for (auto p : v.group<compParties>()) id = p.get<PartyId>();
+//
+//   NewOrder order2;
+//   binary_decode(buf.data(), buf.size(), order2);  // back to the typed message
+//                                                   // for tag=value encoding
+
+#include "message.hpp"
+#include <array>
+#include <cstdint>
+#include <cstring>     // memcpy
+#include <stdexcept>   // std::runtime_error
+#include <string_view>
+#include <utility>     // std::index_sequence
+
+namespace FIX {
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+              "binary codec stores host order, which must be little endian");
+
+enum { BINARY_SCHEMA_VERSION = 2 };
+
+struct BinaryHeader
+{
+  uint32_t length;        // whole message, header included
+  uint16_t version;       // BINARY_SCHEMA_VERSION
+  uint16_t block_length;  // root block
+  char     msg_type[4];   // MsgType, zero padded
+  uint32_t fingerprint;   // of the field list, see Layout<>::fingerprint
+};
+
+static_assert(sizeof(BinaryHeader) == 16, "layout");
+
+namespace binary {
+
+struct Ref { uint32_t offset, length; };  // string or group reference
+
+// Storage of a field value in its slot
+template <typename T> struct slot_of { typedef T type; enum { var = false }; };
+template <> struct slot_of<bool> { typedef uint8_t type; enum { var = false }; };
+template <> struct slot_of<std::string> { typedef Ref type; enum { var = true }; };
+template <> struct slot_of<std::vector<std::string>> { typedef Ref type; enum { var = true }; };
+
+// Layout fingerprint: FNV-1a over 32-bit words
+constexpr uint32_t mix(uint32_t h, uint32_t v) {
+  for (int i = 0; i < 4; ++i, v >>= 8) h = (h ^ (v & 0xff)) * 16777619u;
+  return h;
+}
+
+enum : uint32_t { FNV_BASIS = 2166136261u, OPTIONAL_CODE = 0x100, GROUP_CODE = 0x200, GROUP_END = 0x300 };
+
+template <typename T> constexpr uint32_t type_code() {
+  if constexpr (std::is_same<T, bool>::value) return 1;
+  else if constexpr (std::is_same<T, char>::value) return 2;
+  else if constexpr (std::is_same<T, int>::value) return 3;
+  else if constexpr (std::is_same<T, uint>::value) return 4;
+  else if constexpr (std::is_same<T, long>::value) return 5;
+  else if constexpr (std::is_same<T, ulong>::value) return 6;
+  else if constexpr (std::is_same<T, double>::value) return 7;
+  else if constexpr (std::is_same<T, std::string>::value) return 8;
+  else {
+    static_assert(std::is_same<T, std::vector<std::string>>::value, "no binary code for this type");
+    return 9;
+  }
+}
+
+template <typename Tuple> struct Layout;
+
+template <typename F> struct traits;
+
+template <uint tag_num, typename T, typename R>
+struct traits<Field<tag_num, T, R>>
+{
+  typedef Field<tag_num, T, R> field_type;
+  typedef slot_of<T> slot;
+  typedef typename std::conditional<slot::var, std::string_view, T>::type value_type;
+  enum { size = sizeof(typename slot::type), optional = false, group = false };
+
+  static constexpr uint32_t hash(uint32_t h) { return mix(mix(h, tag_num), type_code<T>()); }
+};
+
+template <typename F>
+struct traits<Optional<F>> : traits<F>
+{
+  enum { optional = true };
+
+  static constexpr uint32_t hash(uint32_t h) { return mix(traits<F>::hash(h), OPTIONAL_CODE); }
+};
+
+template <typename NoField, typename... Fields>
+struct traits<RepeatGroup<NoField, Fields...>>
+{
+  enum { size = sizeof(Ref), optional = false, group = true };
+
+  static constexpr uint32_t hash(uint32_t h) {
+    h = mix(mix(h, NoField::tag), GROUP_CODE);
+    return mix(Layout<typename Group<Fields...>::type>::fingerprint(h), GROUP_END);
+  }
+};
+
+template <typename... Fs>
+struct Layout<std::tuple<Fs...>>
+// Compile-time offsets of each field in a block
+{
+  static constexpr size_t count  = sizeof...(Fs);
+  static constexpr size_t bitmap = (count + 7) / 8;
+
+  static constexpr std::array<size_t, count> offsets() {
+    std::array<size_t, count> o{};
+    size_t sizes[] = { size_t(traits<Fs>::size)..., 0 };
+    size_t off = bitmap;
+    for (size_t i = 0; i < count; ++i) { o[i] = off; off += sizes[i]; }
+    return o;
+  }
+
+  static constexpr size_t block = bitmap + (size_t(0) + ... + size_t(traits<Fs>::size));
+
+  static constexpr uint32_t fingerprint(uint32_t h = FNV_BASIS) {
+    ((h = traits<Fs>::hash(h)), ...);
+    return h;
+  }
+};
+
+template <typename F, typename Tuple> struct index_of;
+
+template <typename F, typename... Fs>
+struct index_of<F, std::tuple<F, Fs...>> { enum { value = 0 }; };
+
+template <typename F, typename F0, typename... Fs>
+struct index_of<F, std::tuple<F0, Fs...>>
+{
+  enum { value = 1 + index_of<F, std::tuple<Fs...>>::value };
+};
+
+inline bool present(char const* block, size_t i) { return (block[i / 8] >> i % 8) & 1; }
+
+template <typename T>
+inline T load(char const* p) { T v; std::memcpy(&v, p, sizeof(T)); return v; }
+
+template <typename T>
+inline void store(std::string& buf, size_t pos, T const& v) { std::memcpy(&buf[pos], &v, sizeof(T)); }
+
+
+//-----------------------------------------------------------------------------
+// Encoding typed groups into blocks
+
+template <typename Tuple>
+void encode_block(Tuple const& fields, std::string& buf, size_t pos);
+
+template <typename T>
+inline Ref append_var(std::string& buf, T const& v) { // string or MultipleString
+  Ref r = { uint32_t(buf.size()), 0 };
+  if constexpr (std::is_same<T, std::string>::value)
+    buf += v;
+  else
+    for (size_t i = 0; i < v.size(); ++i) {
+      if (i) buf += ' ';
+      buf += v[i];
+    }
+  r.length = buf.size() - r.offset;
+  return r;
+}
+
+template <uint tag_num, typename T, typename R>
+inline bool encode_field(Field<tag_num, T, R> const& f, std::string& buf, size_t pos) {
+  typedef slot_of<T> slot;
+  if constexpr (slot::var)
+    store(buf, pos, append_var(buf, f.value()));
+  else
+    store(buf, pos, typename slot::type(f.value()));
+  return true;
+}
+
+template <typename F>
+inline bool encode_field(Optional<F> const& f, std::string& buf, size_t pos) {
+  if (!f) return false;
+  return encode_field(*f, buf, pos);
+}
+
+template <typename NoField, typename... Fields>
+inline bool encode_field(RepeatGroup<NoField, Fields...> const& rg, std::string& buf, size_t pos) {
+  typedef typename RepeatGroup<NoField, Fields...>::group_type group_type;
+  size_t block = Layout<typename group_type::type>::block;
+  auto const& groups = rg.groups();
+
+  Ref r = { uint32_t(buf.size()), uint32_t(groups.size()) };
+  buf.resize(buf.size() + groups.size() * block);
+  store(buf, pos, r);
+  for (size_t i = 0; i < groups.size(); ++i)
+    encode_block(groups[i].fields(), buf, r.offset + i * block);
+  return true;
+}
+
+template <typename Tuple, size_t... I>
+inline void encode_block(Tuple const& fields, std::string& buf, size_t pos, std::index_sequence<I...>) {
+  constexpr auto offsets = Layout<Tuple>::offsets();
+  ((encode_field(std::get<I>(fields), buf, pos + offsets[I])
+    ? void(buf[pos + I / 8] |= char(1 << I % 8)) : void()), ...);
+}
+
+template <typename Tuple>
+inline void encode_block(Tuple const& fields, std::string& buf, size_t pos) {
+  // caller has reserved a zeroed block at pos
+  encode_block(fields, buf, pos, std::make_index_sequence<std::tuple_size<Tuple>::value>());
+}
+
+
+//-----------------------------------------------------------------------------
+// Decoding blocks into typed groups
+
+template <typename Tuple>
+void decode_block(Tuple& fields, char const* base, char const* block);
+
+template <uint tag_num, typename T, typename R>
+inline void decode_field(Field<tag_num, T, R>& f, char const* base, char const* p, bool) {
+  typedef slot_of<T> slot;
+  if constexpr (std::is_same<T, std::string>::value) {
+    Ref r = load<Ref>(p);
+    f = std::string(base + r.offset, r.length);
+  }
+  else if constexpr (slot::var) {  // MultipleString
+    Ref r = load<Ref>(p);
+    T v;
+    std::string_view s(base + r.offset, r.length);
+    for (size_t b = 0, e; b <= s.size() && r.length; b = e + 1) {
+      e = std::min(s.find(' ', b), s.size());
+      v.emplace_back(s.substr(b, e - b));
+    }
+    f = std::move(v);
+  }
+  else
+    f = T(load<typename slot::type>(p));
+}
+
+template <typename F>
+inline void decode_field(Optional<F>& f, char const* base, char const* p, bool present) {
+  if (!present) { f.reset(); return; }
+  f.emplace();
+  decode_field(*f, base, p, true);
+}
+
+template <typename NoField, typename... Fields>
+inline void decode_field(RepeatGroup<NoField, Fields...>& rg, char const* base, char const* p, bool) {
+  typedef typename RepeatGroup<NoField, Fields...>::group_type group_type;
+  size_t block = Layout<typename group_type::type>::block;
+  Ref r = load<Ref>(p);
+  auto& groups = rg.groups();
+  groups.resize(r.length);
+  for (size_t i = 0; i < r.length; ++i)
+    decode_block(groups[i].fields(), base, base + r.offset + i * block);
+}
+
+template <typename Tuple, size_t... I>
+inline void decode_block(Tuple& fields, char const* base, char const* block, std::index_sequence<I...>) {
+  constexpr auto offsets = Layout<Tuple>::offsets();
+  (decode_field(std::get<I>(fields), base, block + offsets[I], present(block, I)), ...);
+}
+
+template <typename Tuple>
+inline void decode_block(Tuple& fields, char const* base, char const* block) {
+  decode_block(fields, base, block, std::make_index_sequence<std::tuple_size<Tuple>::value>());
+}
+
+
+//-----------------------------------------------------------------------------
+// Checking that every reference of a message stays inside it, before anything
+// follows one
+
+template <typename Tuple>
+bool check_block(char const* base, uint32_t length, char const* block);
+
+inline bool inside(Ref r, uint64_t elem_size, uint32_t length) {
+  return uint64_t(r.offset) + uint64_t(r.length) * elem_size <= length;
+}
+
+template <typename F>
+inline bool check_field(char const* base, uint32_t length, char const* p) {
+  typedef traits<F> t;
+  if constexpr (t::group) {
+    typedef typename F::group_type::type group_tuple;
+    size_t block = Layout<group_tuple>::block;
+    Ref r = load<Ref>(p);
+    if (!inside(r, block, length)) return false;
+    for (size_t i = 0; i < r.length; ++i)
+      if (!check_block<group_tuple>(base, length, base + r.offset + i * block)) return false;
+    return true;
+  }
+  else if constexpr (t::slot::var)
+    return inside(load<Ref>(p), 1, length);
+  else
+    return true;
+}
+
+template <typename... Fs, size_t... I>
+inline bool check_block(char const* base, uint32_t length, char const* block,
+                        std::tuple<Fs...>*, std::index_sequence<I...>) {
+  constexpr auto offsets = Layout<std::tuple<Fs...>>::offsets();
+  return (check_field<Fs>(base, length, block + offsets[I]) && ...);
+}
+
+template <typename Tuple>
+inline bool check_block(char const* base, uint32_t length, char const* block) {
+  return check_block(base, length, block, static_cast<Tuple*>(nullptr),
+                     std::make_index_sequence<std::tuple_size<Tuple>::value>());
+}
+
+}  // namespace binary
+
+
+//-----------------------------------------------------------------------------
+// Zero-copy view of a block of group type G (a Group<> or Message<>)
+
+template <typename G>
+class BinaryView
+{
+  typedef typename G::type tuple_type;
+  typedef binary::Layout<tuple_type> layout;
+
+  template <typename F>
+  static constexpr size_t index() { return binary::index_of<F, tuple_type>::value; }
+
+public:
+  BinaryView(char const* base, char const* block) : base_(base), block_(block) {}
+
+  template <typename F>  // false only for absent Optional<>s
+  bool has() const { return binary::present(block_, index<F>()); }
+
+  // F may be a Field or an Optional<Field> (check has<F>() first).
+  // Returns T, or std::string_view into the buffer for strings.
+  template <typename F>
+  typename binary::traits<F>::value_type get() const {
+    typedef binary::traits<F> traits;
+    char const* p = block_ + layout::offsets()[index<F>()];
+    if constexpr (traits::slot::var) {
+      auto r = binary::load<binary::Ref>(p);
+      return std::string_view(base_ + r.offset, r.length);
+    }
+    else
+      return typename traits::value_type(binary::load<typename traits::slot::type>(p));
+  }
+
+  template <typename RG>
+  class Range
+  {
+    typedef BinaryView<typename RG::group_type> view_type;
+    enum { block = binary::Layout<typename RG::group_type::type>::block };
+
+  public:
+    Range(char const* base, binary::Ref r) : base_(base), r_(r) {}
+
+    size_t size() const { return r_.length; }
+    view_type operator[](size_t i) const {
+      return view_type(base_, base_ + r_.offset + i * block);
+    }
+
+    struct iterator
+    {
+      Range const* range; size_t i;
+      view_type operator*() const { return (*range)[i]; }
+      iterator& operator++() { ++i; return *this; }
+      bool operator!=(iterator const& o) const { return i != o.i; }
+    };
+    iterator begin() const { return iterator{this, 0}; }
+    iterator end() const { return iterator{this, size()}; }
+
+  private:
+    char const* base_;
+    binary::Ref r_;
+  };
+
+  template <typename RG>  // RG is a RepeatGroup<>
+  Range<RG> group() const {
+    return Range<RG>(base_, binary::load<binary::Ref>(block_ + layout::offsets()[index<RG>()]));
+  }
+
+protected:
+  char const* base_;   // start of message
+  char const* block_;  // start of this block
+};
+
+
+template <typename Msg>
+class BinaryMessage : public BinaryView<Msg>
+// View of a whole binary message; the buffer must outlive it
+{
+public:
+  BinaryMessage(char const* buf, size_t size)
+    : BinaryView<Msg>(buf, buf + sizeof(BinaryHeader))
+  {
+    if (!check(buf, size)) throw std::runtime_error("Binary Message Decoding Error");
+  }
+
+  // Header, and every string and group reference, within the message
+  static bool check(char const* buf, size_t size) {
+    if (size < sizeof(BinaryHeader)) return false;
+    auto h = binary::load<BinaryHeader>(buf);
+    return h.length <= size &&
+           h.version == BINARY_SCHEMA_VERSION &&
+           h.block_length == binary::Layout<typename Msg::type>::block &&
+           h.fingerprint == binary::Layout<typename Msg::type>::fingerprint() &&
+           h.length >= sizeof(BinaryHeader) + h.block_length &&
+           std::string_view(h.msg_type, strnlen(h.msg_type, sizeof(h.msg_type))) ==
+             typename Msg::msg_type_type().value() &&
+           binary::check_block<typename Msg::type>(buf, h.length, buf + sizeof(BinaryHeader));
+  }
+
+  uint32_t length() const { return binary::load<uint32_t>(this->base_); }
+};
+
+
+template <typename Msg>
+inline void binary_encode(Msg const& msg, std::string& buf)
+{
+  typedef binary::Layout<typename Msg::type> layout;
+  static_assert(layout::block <= 0xffff, "block too large");
+
+  buf.assign(sizeof(BinaryHeader) + layout::block, '\0');
+  binary::encode_block(msg.fields(), buf, sizeof(BinaryHeader));
+
+  BinaryHeader h = { uint32_t(buf.size()), BINARY_SCHEMA_VERSION, uint16_t(layout::block), {},
+                     layout::fingerprint() };
+  std::string const& mt = msg.template get<MsgType>().value();
+  std::memcpy(h.msg_type, mt.data(), std::min(mt.size(), sizeof(h.msg_type)));
+  binary::store(buf, 0, h);
+}
+
+template <typename Msg>  // Returns false if buf does not hold a Msg, or a reference is out of range
+inline bool binary_decode(char const* buf, size_t size, Msg& msg)
+{
+  if (!BinaryMessage<Msg>::check(buf, size)) return false;
+  binary::decode_block(msg.fields(), buf, buf + sizeof(BinaryHeader));
+  return true;
+}
+
+}  // namespace FIX
+
+#endif
@@ -0,0 +1,504 @@
+#ifndef FIX_COLUMNAR_HPP_
+#define FIX_COLUMNAR_HPP_
+
+// Columnar (struct-of-arrays) export of decoded messages.
+//
+// One table per MsgType, one column per field in the message's field list
+// (header included, nested components flattened).  Optional<> fields get a
+// validity bitmap; strings are stored as offsets + data.  A RepeatGroup<>
+// becomes a count column in its parent and a child table named
+// "<parent>.<NoXXX tag>" whose first column (tag 0) is the parent row.
+//
+// Usage:
+//   ColumnarWriter<NewOrder, Logon> w;
+//   w.append(order);  ...
+//   w.write("orders.fixc");
+//
+//   ColumnarFile f("orders.fixc");   // mmap'ed, nothing deserialised
+//   auto t   = f.table("D");
+//   auto qty = t.column(OrderQty::tag);
+//   for (size_t i = 0; i < t.rows(); ++i) sum += qty.value<double>(i);
+//
+// File layout (little endian, every block 8-byte aligned):
+//   ColumnarHeader
+//   ColumnarTable[num_tables]
+//   ColumnarColumn[num_columns]
+//   column buffers
+
+#include "message.hpp"
+#include "mapped_file.hpp"
+#include <cstdint>
+#include <cstdio>      // fopen, fwrite
+#include <cstring>     // memcpy, memchr
+#include <string_view>
+#include <utility>     // std::index_sequence
+
+namespace FIX {
+
+enum class ColumnKind : uint8_t { Bool, Char, Int32, UInt32, Int64, UInt64, Float64, String };
+
+enum { COLUMNAR_VERSION = 1 };
+enum : uint32_t { NO_PARENT = ~0u };
+
+struct ColumnarHeader
+{
+  char     magic[4];     // "FIXC"
+  uint32_t version;
+  uint32_t num_tables;
+  uint32_t num_columns;
+};
+
+struct ColumnarTable
+{
+  char     name[24];     // MsgType, or "<parent>.<tag>" for repeating groups
+  uint32_t parent;       // index of parent table, or NO_PARENT
+  uint32_t first_column; // index into the column entries
+  uint32_t num_columns;
+  uint32_t reserved;
+  uint64_t num_rows;
+};
+
+struct ColumnarColumn
+{
+  uint32_t   tag;        // 0 for the parent row column of child tables
+  ColumnKind kind;
+  uint8_t    nullable;
+  uint16_t   reserved;
+  uint64_t   validity;   // file offset of bitmap, bit i set if row i present
+  uint64_t   values;     // fixed width values, or num_rows+1 uint64 offsets for String
+  uint64_t   values_size;
+  uint64_t   data;       // characters of String columns
+  uint64_t   data_size;
+};
+
+static_assert(sizeof(ColumnarHeader) == 16, "layout");
+static_assert(sizeof(ColumnarTable)  == 48, "layout");
+static_assert(sizeof(ColumnarColumn) == 48, "layout");
+
+
+//-----------------------------------------------------------------------------
+// Building columns
+
+namespace columnar {
+
+template <typename T> struct kind_of;
+template <> struct kind_of<bool>   { enum : uint8_t { value = uint8_t(ColumnKind::Bool) }; };
+template <> struct kind_of<char>   { enum : uint8_t { value = uint8_t(ColumnKind::Char) }; };
+template <> struct kind_of<int>    { enum : uint8_t { value = uint8_t(ColumnKind::Int32) }; };
+template <> struct kind_of<uint>   { enum : uint8_t { value = uint8_t(ColumnKind::UInt32) }; };
+template <> struct kind_of<long>   { enum : uint8_t { value = uint8_t(ColumnKind::Int64) }; };
+template <> struct kind_of<ulong>  { enum : uint8_t { value = uint8_t(ColumnKind::UInt64) }; };
+template <> struct kind_of<double> { enum : uint8_t { value = uint8_t(ColumnKind::Float64) }; };
+
+struct Buffer { void const* ptr; size_t size; };
+
+struct ColumnDesc
+{
+  uint32_t tag;
+  ColumnKind kind;
+  bool nullable;
+  Buffer validity, values, data;
+};
+
+struct TableDesc
+{
+  std::string name;
+  uint32_t parent;
+  uint64_t rows;
+  std::vector<ColumnDesc> columns;
+};
+
+template <typename T>
+struct Store
+// Fixed width values
+{
+  typedef typename std::conditional<std::is_same<T, bool>::value, uint8_t, T>::type value_type;
+  std::vector<value_type> values;
+
+  void push(T const& v) { values.push_back(v); }
+  void push_null() { values.push_back(value_type()); }
+
+  ColumnDesc desc(uint32_t tag) const {
+    return ColumnDesc{tag, ColumnKind(kind_of<T>::value), false, {nullptr, 0},
+                      {values.data(), values.size() * sizeof(value_type)}, {nullptr, 0}};
+  }
+};
+
+template <>
+struct Store<std::string>
+{
+  std::vector<uint64_t> offsets = {0};
+  std::string data;
+
+  void push(std::string const& v) { data += v; offsets.push_back(data.size()); }
+  void push_null() { offsets.push_back(data.size()); }
+
+  ColumnDesc desc(uint32_t tag) const {
+    return ColumnDesc{tag, ColumnKind::String, false, {nullptr, 0},
+                      {offsets.data(), offsets.size() * sizeof(uint64_t)},
+                      {data.data(), data.size()}};
+  }
+};
+
+template <>
+struct Store<std::vector<std::string>> : Store<std::string>
+// MultipleString: values joined by ' ', as on the wire
+{
+  void push(std::vector<std::string> const& v) {
+    for (size_t i = 0; i < v.size(); ++i) {
+      if (i) data += ' ';
+      data += v[i];
+    }
+    offsets.push_back(data.size());
+  }
+};
+
+template <typename Fields> class Table;  // Fields is a tuple
+
+template <typename F> struct Column;
+
+template <uint tag_num, typename T, typename R>
+struct Column<Field<tag_num, T, R>>
+{
+  Store<T> store;
+
+  void append(Field<tag_num, T, R> const& f, uint64_t) { store.push(f.value()); }
+  void describe(TableDesc& t) const { t.columns.push_back(store.desc(tag_num)); }
+  void describe_children(std::vector<TableDesc>&, uint32_t, std::string const&) const {}
+};
+
+template <typename F>
+struct Column<Optional<F>> : Column<F>
+{
+  std::vector<uint8_t> validity;
+  uint64_t rows = 0;
+
+  void append(Optional<F> const& f, uint64_t row) {
+    if (rows % 8 == 0) validity.push_back(0);
+    if (f) {
+      validity.back() |= uint8_t(1u << rows % 8);
+      Column<F>::append(*f, row);
+    }
+    else
+      this->store.push_null();
+    ++rows;
+  }
+
+  void describe(TableDesc& t) const {
+    Column<F>::describe(t);
+    t.columns.back().nullable = true;
+    t.columns.back().validity = Buffer{validity.data(), validity.size()};
+  }
+};
+
+template <typename NoField, typename... Fields>
+struct Column<RepeatGroup<NoField, Fields...>>
+{
+  typedef RepeatGroup<NoField, Fields...> group_type;
+
+  Store<uint> count;
+  Table<typename group_type::group_type::type> child;
+
+  void append(group_type const& rg, uint64_t row) {
+    count.push(rg.groups().size());
+    for (auto const& g : rg.groups()) child.append(g, row);
+  }
+
+  void describe(TableDesc& t) const { t.columns.push_back(count.desc(NoField::tag)); }
+
+  void describe_children(std::vector<TableDesc>& out, uint32_t self,
+                         std::string const& name) const {
+    child.describe(out, name + '.' + std::to_string(uint(NoField::tag)), self);
+  }
+};
+
+template <typename... Fs>
+class Table<std::tuple<Fs...>>
+{
+public:
+  template <typename G>
+  void append(G const& g) { append(g.fields(), std::index_sequence_for<Fs...>()); }
+
+  template <typename G>
+  void append(G const& g, uint64_t parent_row) {
+    parents_.push_back(parent_row);
+    append(g);
+  }
+
+  uint64_t rows() const { return rows_; }
+
+  void describe(std::vector<TableDesc>& out, std::string const& name, uint32_t parent) const
+  {
+    uint32_t self = out.size();
+    out.push_back(TableDesc{name, parent, rows_, {}});
+    if (parent != NO_PARENT)
+      out.back().columns.push_back(ColumnDesc{0, ColumnKind::UInt64, false, {nullptr, 0},
+        {parents_.data(), parents_.size() * sizeof(uint64_t)}, {nullptr, 0}});
+    std::apply([&](auto const&... c) { (c.describe(out[self]), ...); }, cols_);
+    // children after all our columns; out may grow from here on
+    std::apply([&](auto const&... c) { (c.describe_children(out, self, name), ...); }, cols_);
+  }
+
+private:
+  template <size_t... I>
+  void append(std::tuple<Fs...> const& fields, std::index_sequence<I...>) {
+    (std::get<I>(cols_).append(std::get<I>(fields), rows_), ...);
+    ++rows_;
+  }
+
+  std::tuple<Column<Fs>...> cols_;
+  std::vector<uint64_t> parents_;  // child tables only
+  uint64_t rows_ = 0;
+};
+
+}  // namespace columnar
+
+
+template <typename Msg, typename... Msgs>
+class ColumnarWriter
+// Accumulates messages in column buffers and writes them out as one file
+{
+  template <typename M> using table_type = columnar::Table<typename M::type>;
+
+  template <typename M, typename M0, typename... Ms>  // position of M in the list
+  static constexpr size_t index_of() {
+    if constexpr (std::is_same<M, M0>::value) return 0;
+    else return 1 + index_of<M, Ms...>();
+  }
+
+public:
+  template <typename M>
+  void append(M const& msg) { std::get<index_of<M, Msg, Msgs...>()>(tables_).append(msg); }
+
+  void write(char const* path) const
+  {
+    std::vector<columnar::TableDesc> descs;
+    describe<Msg, Msgs...>(descs);
+    for (size_t i = 0; i < descs.size(); ++i) {  // names are how tables are found
+      if (descs[i].name.size() >= sizeof(ColumnarTable::name))
+        throw std::runtime_error("Columnar table name too long: " + descs[i].name);
+      for (size_t j = 0; j < i; ++j)
+        if (descs[j].name == descs[i].name)
+          throw std::runtime_error("Duplicate columnar table name: " + descs[i].name);
+    }
+
+    uint32_t num_columns = 0;
+    for (auto const& t : descs) num_columns += t.columns.size();
+
+    std::vector<ColumnarTable> tables(descs.size());
+    std::vector<ColumnarColumn> columns;
+    std::vector<columnar::Buffer> blobs;  // in file order
+
+    uint64_t offset = sizeof(ColumnarHeader) + tables.size() * sizeof(ColumnarTable)
+                    + num_columns * sizeof(ColumnarColumn);
+    auto place = [&](columnar::Buffer const& b) -> uint64_t {
+      if (!b.ptr) return 0;
+      uint64_t at = offset;
+      blobs.push_back(b);
+      offset += align(b.size);
+      return at;
+    };
+
+    for (size_t i = 0; i < descs.size(); ++i) {
+      auto const& d = descs[i];
+      auto& t = tables[i];
+      std::memset(&t, 0, sizeof(t));
+      std::memcpy(t.name, d.name.c_str(), d.name.size());
+      t.parent = d.parent;
+      t.first_column = columns.size();
+      t.num_columns = d.columns.size();
+      t.num_rows = d.rows;
+      for (auto const& c : d.columns) {
+        ColumnarColumn cc;
+        std::memset(&cc, 0, sizeof(cc));
+        cc.tag = c.tag;
+        cc.kind = c.kind;
+        cc.nullable = c.nullable;
+        cc.validity = place(c.validity);
+        cc.values_size = c.values.size;
+        cc.values = place(c.values);
+        cc.data_size = c.data.size;
+        cc.data = place(c.data);
+        columns.push_back(cc);
+      }
+    }
+
+    ColumnarHeader h = {{'F', 'I', 'X', 'C'}, COLUMNAR_VERSION,
+                        uint32_t(tables.size()), num_columns};
+
+    std::FILE* f = std::fopen(path, "wb");
+    if (!f) throw std::runtime_error(std::string("Cannot open ") + path);
+    static char const zeros[8] = {};
+    bool ok = std::fwrite(&h, sizeof(h), 1, f) == 1
+      && std::fwrite(tables.data(), sizeof(ColumnarTable), tables.size(), f) == tables.size()
+      && std::fwrite(columns.data(), sizeof(ColumnarColumn), columns.size(), f) == columns.size();
+    for (auto const& b : blobs) {
+      if (!ok) break;
+      ok = std::fwrite(b.ptr, 1, b.size, f) == b.size
+        && std::fwrite(zeros, 1, align(b.size) - b.size, f) == align(b.size) - b.size;
+    }
+    if (std::fclose(f) != 0 || !ok)
+      throw std::runtime_error(std::string("Cannot write ") + path);
+  }
+
+private:
+  static uint64_t align(uint64_t n) { return (n + 7) & ~uint64_t(7); }
+
+  template <typename M, typename... Ms>
+  void describe(std::vector<columnar::TableDesc>& out) const {
+    std::get<index_of<M, Msg, Msgs...>()>(tables_).describe(
+      out, typename M::msg_type_type().value(), NO_PARENT);
+    if constexpr (sizeof...(Ms) != 0) describe<Ms...>(out);
+  }
+
+  std::tuple<table_type<Msg>, table_type<Msgs>...> tables_;
+};
+
+
+//-----------------------------------------------------------------------------
+// Reading a columnar file in place
+
+class ColumnView
+{
+public:
+  ColumnView(char const* base, ColumnarColumn const* c) : base_(base), c_(c) {}
+
+  uint32_t tag() const { return c_->tag; }
+  ColumnKind kind() const { return c_->kind; }
+
+  bool valid(size_t row) const {
+    if (!c_->nullable) return true;
+    return (base_[c_->validity + row / 8] >> row % 8) & 1;
+  }
+
+  template <typename T>  // T must match kind(); bool columns are read as uint8_t
+  T value(size_t row) const {
+    T v;
+    std::memcpy(&v, base_ + c_->values + row * sizeof(T), sizeof(T));
+    return v;
+  }
+
+  std::string_view str(size_t row) const {
+    uint64_t b = value<uint64_t>(row), e = value<uint64_t>(row + 1);
+    return std::string_view(base_ + c_->data + b, e - b);
+  }
+
+private:
+  char const* base_;
+  ColumnarColumn const* c_;
+};
+
+class TableView
+{
+public:
+  TableView(char const* base, ColumnarTable const* t) : base_(base), t_(t) {}
+
+  explicit operator bool() const { return t_ != nullptr; }
+  std::string_view name() const { return t_->name; }
+  uint64_t rows() const { return t_->num_rows; }
+  uint32_t parent() const { return t_->parent; }
+  size_t num_columns() const { return t_->num_columns; }
+
+  ColumnView column_at(size_t i) const {
+    return ColumnView(base_, columns() + t_->first_column + i);
+  }
+
+  ColumnView column(uint32_t tag) const {  // throws if no such column
+    for (size_t i = 0; i < t_->num_columns; ++i)
+      if (columns()[t_->first_column + i].tag == tag) return column_at(i);
+    throw std::runtime_error("No such column: " + std::to_string(tag));
+  }
+
+private:
+  friend class ColumnarFile;
+
+  ColumnarColumn const* columns() const {
+    auto h = reinterpret_cast<ColumnarHeader const*>(base_);
+    return reinterpret_cast<ColumnarColumn const*>(
+      base_ + sizeof(ColumnarHeader) + h->num_tables * sizeof(ColumnarTable));
+  }
+
+  char const* base_;
+  ColumnarTable const* t_;
+};
+
+class ColumnarFile
+{
+public:
+  explicit ColumnarFile(char const* path) : file_(path) {
+    if (file_.size() < sizeof(ColumnarHeader) || std::memcmp(file_.data(), "FIXC", 4) != 0)
+      throw std::runtime_error(std::string("Not a columnar FIX file: ") + path);
+    if (header().version != COLUMNAR_VERSION)
+      throw std::runtime_error(std::string("Unsupported columnar version: ") + path);
+    if (!valid())
+      throw std::runtime_error(std::string("Corrupt columnar FIX file: ") + path);
+  }
+
+  size_t num_tables() const { return header().num_tables; }
+
+  TableView table_at(size_t i) const { return TableView(file_.data(), tables() + i); }
+
+  TableView table(std::string_view name) const {  // empty view if not found
+    for (size_t i = 0; i < num_tables(); ++i)
+      if (name == tables()[i].name) return table_at(i);
+    return TableView(file_.data(), nullptr);
+  }
+
+private:
+  bool fits(uint64_t off, uint64_t len) const {
+    return off <= file_.size() && len <= file_.size() - off;
+  }
+
+  bool valid() const
+  // Every table, column and buffer lies inside the file, so the views never
+  // read past it
+  {
+    static uint8_t const width[] = { 1, 1, 4, 4, 8, 8, 8, 8 };  // by ColumnKind
+    auto const& h = header();
+    if (!fits(sizeof(ColumnarHeader), uint64_t(h.num_tables) * sizeof(ColumnarTable)
+                                      + uint64_t(h.num_columns) * sizeof(ColumnarColumn)))
+      return false;
+    auto cols = TableView(file_.data(), nullptr).columns();
+
+    for (size_t i = 0; i < h.num_tables; ++i) {
+      auto const& t = tables()[i];
+      if (!std::memchr(t.name, 0, sizeof(t.name))) return false;
+      if (t.parent != NO_PARENT && t.parent >= h.num_tables) return false;
+      if (uint64_t(t.first_column) + t.num_columns > h.num_columns) return false;
+      if (t.num_rows > file_.size()) return false;  // also keeps the sizes below from overflowing
+
+      for (size_t j = 0; j < t.num_columns; ++j) {
+        auto const& c = cols[t.first_column + j];
+        if (uint8_t(c.kind) > uint8_t(ColumnKind::String)) return false;
+        bool str = c.kind == ColumnKind::String;
+        if (c.values_size < (t.num_rows + str) * width[uint8_t(c.kind)]
+            || !fits(c.values, c.values_size))
+          return false;
+        if (c.nullable && !fits(c.validity, (t.num_rows + 7) / 8)) return false;
+        if (str) {
+          if (!fits(c.data, c.data_size)) return false;
+          ColumnView v(file_.data(), &c);
+          for (uint64_t r = 0, prev = 0; r <= t.num_rows; ++r) {
+            uint64_t o = v.value<uint64_t>(r);
+            if (o < prev || o > c.data_size) return false;
+            prev = o;
+          }
+        }
+      }
+    }
+    return true;
+  }
+
+  ColumnarHeader const& header() const {
+    return *reinterpret_cast<ColumnarHeader const*>(file_.data());
+  }
+  ColumnarTable const* tables() const {
+    return reinterpret_cast<ColumnarTable const*>(file_.data() + sizeof(ColumnarHeader));
+  }
+
+  MappedFile file_;
+};
+
+}  // namespace FIX
+
+#endif
@@ -155,6 +155,33 @@ using ValueCheckType        = Int<1869>;
 using ValueCheckAction      = Int<1870>;
 using ExchangeTradeType     = Char<5681>;
 
+// Capacities for encoding into a fixed buffer (see wire.hpp).  Generous, so
+// that valid values never hit them; set to the venue's limits for a tighter
+// Message::max_size.  String fields not listed here are unbounded.
+
+DEF_CAPACITY(BeginString,      8)   // "FIXT.1.1"
+DEF_CAPACITY(MsgType,          4)
+DEF_CAPACITY(SenderCompId,    32)
+DEF_CAPACITY(TargetCompId,    32)
+DEF_CAPACITY(SendingTime,     27)   // YYYYMMDD-HH:MM:SS.sssssssss
+DEF_CAPACITY(OrigSendingTime, 27)
+DEF_CAPACITY(TransactTime,    27)
+DEF_CAPACITY(ApplVerId,        4)
+DEF_CAPACITY(DefaultApplVerId, 4)
+DEF_CAPACITY(TestRequestId,   32)
+DEF_CAPACITY(RefMsgType,       4)
+DEF_CAPACITY(Text,           128)
+DEF_CAPACITY(ClOrdId,         32)
+DEF_CAPACITY(OrigClOrdId,     32)
+DEF_CAPACITY(OrderId,         32)
+DEF_CAPACITY(ExecId,          32)
+DEF_CAPACITY(SecurityId,      32)
+DEF_CAPACITY(SecurityIdSource, 4)
+DEF_CAPACITY(SecurityExchange, 8)
+DEF_CAPACITY(PartyId,         32)
+DEF_CAPACITY(ExecInst,         8)
+DEF_CAPACITY(OrderRestrictions, 8)
+
 // Below not used in HKEx OCG
 using ResetSeqnumFlag = Boolean<141>;
 
@@ -173,6 +173,14 @@ struct Optional : boost::optional<Field>
 };
 
 
+// Most characters (strings) or entries (RepeatGroup) a field may hold when
+// encoded into a fixed buffer, see wire.hpp; 0 = not bounded.
+template <typename F> struct capacity { enum { value = 0 }; };
+
+#define DEF_CAPACITY(field, n) \
+template <> struct capacity<field> { enum { value = n }; };
+
+
 // FIX  field types
 
 template <uint tag_num> using Boolean  = Field<tag_num, bool>;
@@ -0,0 +1,227 @@
+#ifndef FIX_FRAME_HPP_
+#define FIX_FRAME_HPP_
+
+// Raw frame helpers: locate "8=...|9=N|...|10=xxx|" frames in a byte buffer and
+// look up fields in them without decoding into a typed Message.
+// The delimiter is SOH normally, or '|' for human readable logs.
+
+#include "field.hpp"
+#include <algorithm>   // std::min
+#include <cstring>     // memcmp, memchr
+#include <string_view> // std::string_view
+
+namespace FIX {
+
+enum { SOH = '\x01' };
+enum { TRAILER_SIZE = 7 };  // "10=xxx" plus delimiter
+
+struct Frame
+// [begin, end) covers a whole message, from "8=" up to the delimiter after CheckSum
+{
+  char const* begin = nullptr;
+  char const* end   = nullptr;
+  char delim = SOH;
+
+  size_t size() const { return end - begin; }
+  std::string_view str() const { return std::string_view(begin, size()); }
+
+  // Value of the first occurrence of tag, or an empty view with data() == nullptr
+  std::string_view field(uint tag) const;
+  std::string_view msgType() const { return field(35); }
+};
+
+namespace detail {
+
+enum { MAX_UINT_DIGITS = 9 };  // tags and BodyLength; more is corrupt, and could overflow
+
+inline bool parse_uint(char const*& p, char const* e, char stop, size_t& v)
+// Parses up to MAX_UINT_DIGITS digits up to stop; p is left just past stop
+{
+  if (p == e || *p < '0' || *p > '9') return false;
+  v = 0;
+  char const* b = p;
+  for (; p != e && *p >= '0' && *p <= '9'; ++p) v = v * 10 + (*p - '0');
+  if (p - b > MAX_UINT_DIGITS) return false;
+  if (p == e || *p != stop) return false;
+  ++p;
+  return true;
+}
+
+inline bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+}  // namespace detail
+
+enum class FrameStatus { Complete, Partial, Bad };
+
+// Checks the frame starting at b.  len is set to the whole frame length as
+// soon as BodyLength has been read, so a Partial frame may tell how many
+// bytes it still needs.
+inline FrameStatus check_frame(char const* b, char const* e, size_t& len, char delim = SOH)
+{
+  enum { MAX_HEAD = 32 };  // longest "8=...|" or BodyLength digits we accept
+  len = 0;
+  size_t n = e - b;
+  if (n < 2)
+    return n == 0 || b[0] == '8' ? FrameStatus::Partial : FrameStatus::Bad;
+  if (b[0] != '8' || b[1] != '=') return FrameStatus::Bad;
+
+  char const* p = static_cast<char const*>(std::memchr(b + 2, delim, n - 2));
+  if (!p) return n > MAX_HEAD ? FrameStatus::Bad : FrameStatus::Partial;
+  if (e - ++p < 2)
+    return p == e || *p == '9' ? FrameStatus::Partial : FrameStatus::Bad;
+  if (p[0] != '9' || p[1] != '=') return FrameStatus::Bad;
+
+  p += 2;
+  char const* q = p;
+  while (q != e && detail::is_digit(*q)) ++q;
+  if (q - p > detail::MAX_UINT_DIGITS) return FrameStatus::Bad;
+  if (q == e) return FrameStatus::Partial;
+  size_t body_len;
+  if (!detail::parse_uint(p, e, delim, body_len)) return FrameStatus::Bad;
+
+  len = p - b + body_len + TRAILER_SIZE;
+  if (n < len) return FrameStatus::Partial;
+  char const* t = b + len - TRAILER_SIZE;
+  if (std::memcmp(t, "10=", 3) != 0 || t[TRAILER_SIZE-1] != delim) return FrameStatus::Bad;
+  return FrameStatus::Complete;
+}
+
+// Length of the frame starting at b ("8=..."), or 0 if b..e does not hold a
+// complete well-formed frame (bad BodyLength, missing "10=").
+inline size_t frame_length(char const* b, char const* e, char delim = SOH)
+{
+  size_t len;
+  return check_frame(b, e, len, delim) == FrameStatus::Complete ? len : 0;
+}
+
+// Next position in [b, e) that starts a well-formed frame, or e if none.
+// A frame must begin the buffer or follow a non-digit, so "18=..." is skipped.
+// buf_begin is the start of the whole buffer when b points into its middle.
+inline char const* find_frame(char const* b, char const* e, char delim = SOH,
+                              char const* buf_begin = nullptr)
+{
+  if (!buf_begin) buf_begin = b;
+  for (char const* p = b; e - p >= 2; ++p) {
+    p = static_cast<char const*>(std::memchr(p, '8', e - p - 1));
+    if (!p) break;
+    if (p[1] != '=') continue;
+    if (p != buf_begin && detail::is_digit(p[-1])) continue;
+    if (frame_length(p, e, delim)) return p;
+  }
+  return e;
+}
+
+inline std::string_view find_field(char const* b, char const* e, uint tag, char delim = SOH)
+// Scans "tag=value<delim>" pairs in [b, e)
+{
+  while (b < e) {
+    size_t t;
+    char const* v = b;
+    if (!detail::parse_uint(v, e, '=', t)) break;
+    char const* d = static_cast<char const*>(std::memchr(v, delim, e - v));
+    if (!d) break;
+    if (t == tag) return std::string_view(v, d - v);
+    b = d + 1;
+  }
+  return std::string_view();
+}
+
+inline std::string_view Frame::field(uint tag) const
+{
+  return find_field(begin, end, tag, delim);
+}
+
+
+class Framer
+// Splits a byte stream (e.g. socket reads) into frames.  Frames lying wholly
+// inside one buffer are handed out in place; only a frame split across
+// buffers is copied, into carry_.  A BodyLength making the frame longer than
+// max_frame counts as garbage, so a peer cannot make carry_ grow unbounded.
+{
+public:
+  enum : size_t { DEFAULT_MAX_FRAME = 1 << 20 };
+
+  explicit Framer(char delim = SOH, size_t max_frame = DEFAULT_MAX_FRAME)
+    : delim_(delim), max_frame_(max_frame) {}
+
+  // Calls f(Frame const&) for each complete frame in [p, e); the frame is only
+  // valid during the call.  Returns the number of bytes skipped as garbage.
+  template <typename F>
+  size_t feed(char const* p, char const* e, F&& f)
+  {
+    enum : size_t { HEAD_STEP = 64 };  // bytes taken at a time until BodyLength is known
+    size_t skipped = 0;
+
+    // carry_ may hold more than one frame: dropping a Bad frame up to the next
+    // '8' can leave a shorter complete frame and bytes past it
+    size_t take = 0;  // bytes last appended from [p, e)
+    while (!carry_.empty()) {
+      size_t len;
+      auto st = check(carry_.data(), carry_.data() + carry_.size(), len);
+      if (st == FrameStatus::Complete) {
+        size_t back = std::min(carry_.size() - len, take);  // give back what came from p
+        carry_.resize(carry_.size() - back);
+        p -= back;
+        take = 0;
+        f(Frame{carry_.data(), carry_.data() + len, delim_});
+        carry_.erase(0, len);
+      }
+      else if (st == FrameStatus::Bad) {
+        size_t next = carry_.find('8', 1);
+        if (next == std::string::npos) next = carry_.size();
+        skipped += next;
+        carry_.erase(0, next);
+        take = std::min(take, carry_.size());
+      }
+      else if (p == e)
+        break;
+      else {  // Partial: len, if known, is past what carry_ holds
+        if (len) carry_.reserve(len);
+        take = std::min<size_t>(e - p, len ? len - carry_.size() : HEAD_STEP);
+        carry_.append(p, take);
+        p += take;
+      }
+    }
+
+    while (p != e) {
+      size_t len;
+      auto st = check(p, e, len);
+      if (st == FrameStatus::Complete) {
+        f(Frame{p, p + len, delim_});
+        p += len;
+      }
+      else if (st == FrameStatus::Partial) {
+        carry_.assign(p, e);
+        break;
+      }
+      else {
+        char const* q = static_cast<char const*>(std::memchr(p + 1, '8', e - p - 1));
+        if (!q) q = e;
+        skipped += q - p;
+        p = q;
+      }
+    }
+    return skipped;
+  }
+
+  size_t pending() const { return carry_.size(); }  // bytes of an incomplete frame
+
+private:
+  FrameStatus check(char const* b, char const* e, size_t& len) const
+  {
+    auto st = check_frame(b, e, len, delim_);
+    if (len > max_frame_) {
+      len = 0;
+      return FrameStatus::Bad;
+    }
+    return st;
+  }
+
+  std::string carry_;
+  char delim_;
+  size_t max_frame_;
+};
+
+}  // namespace FIX
+
+#endif
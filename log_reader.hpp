@@ -0,0 +1,332 @@
+#ifndef FIX_LOG_READER_HPP_
+#define FIX_LOG_READER_HPP_
+
+// Parallel scanner for FIX log files (SOH delimited, or with '|' substituted).
+// The file is mmap'ed, split into chunks at frame boundaries, and the chunks
+// are filtered and decoded on several threads.
+//
+// Usage:
+//   LogReader log("20240102.fix");
+//   LogFilter filter;
+//   filter.msgType("D").where(48, [](std::string_view v) { return v == "700"; });
+//   log.frames(filter, [](Frame const& f) { ... });  // raw, on this thread
+//   log.scan<Order>(filter, [](Frame const& f, Order& msg) { ... });
+//
+// scan's Msg is any default constructible type with
+//   bool decode(char const*& begin, char const* end)
+// taking one SOH delimited frame.  Message<>::decode has that signature, but
+// its qi rules do not compile in this tree yet, so for now Msg is a type of
+// your own that reads what it needs, e.g. with find_field().
+
+#include "frame.hpp"
+#include "mapped_file.hpp"
+#include <algorithm>  // std::min, std::find
+#include <atomic>
+#include <condition_variable>
+#include <exception>  // std::exception_ptr
+#include <functional> // std::function
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace FIX {
+
+struct LogFilter
+// Cheap checks on the raw frame, run before any decoding.
+// An empty filter accepts every frame.
+{
+  typedef std::function<bool(std::string_view)> predicate_type;
+
+  LogFilter& msgType(std::string mt) { msg_types.push_back(std::move(mt)); return *this; }
+  LogFilter& where(uint tag, predicate_type p) { preds.emplace_back(tag, std::move(p)); return *this; }
+  LogFilter& has(uint tag) { return where(tag, predicate_type()); }
+
+  bool operator()(Frame const& f) const {
+    if (!msg_types.empty() &&
+        std::find(msg_types.begin(), msg_types.end(), f.msgType()) == msg_types.end())
+      return false;
+    for (auto const& p : preds) {
+      auto v = f.field(p.first);
+      if (!v.data() || (p.second && !p.second(v))) return false;
+    }
+    return true;
+  }
+
+  std::vector<std::string> msg_types;  // any of them
+  std::vector<std::pair<uint, predicate_type>> preds;  // all of them
+};
+
+
+struct ScanStats
+{
+  size_t frames  = 0;  // well formed frames seen
+  size_t matched = 0;  // passed the filter
+  size_t errors  = 0;  // matched but failed to decode
+
+  ScanStats& operator+=(ScanStats const& s) {
+    frames += s.frames; matched += s.matched; errors += s.errors;
+    return *this;
+  }
+};
+
+enum class Delivery { Ordered, Unordered };
+
+
+class LogReader
+{
+public:
+  explicit LogReader(char const* path, char delim = 0) : file_(path) {
+    delim_ = delim ? delim : detect_delim();
+  }
+
+  char delim() const { return delim_; }
+
+  // Calls f(Frame const&) for every frame passing filter, in file order, on this thread.
+  template <typename F>
+  ScanStats frames(LogFilter const& filter, F&& f) const
+  {
+    ScanStats stats;
+    scan_range(file_.data(), file_.data() + file_.size(), filter, stats,
+               [&](Frame const& fr) { f(fr); });
+    return stats;
+  }
+
+  //---------------------------------------------------------------------------
+  // Decodes every frame passing filter into a Msg and calls f(Frame const&, Msg&).
+  // Ordered:   f is called on this thread, in file order.  Workers stay at
+  //            most ORDERED_WINDOW chunks per thread ahead of f, so a slow f
+  //            holds back decoding instead of piling up decoded messages.
+  // Unordered: f is called on the worker threads as soon as a frame is
+  //            decoded, so it must be thread-safe.
+  // threads == 0 uses std::thread::hardware_concurrency().  If f or
+  // Msg::decode throws, the workers are stopped and joined and the first
+  // exception is rethrown here.
+  //---------------------------------------------------------------------------
+  template <typename Msg, typename F>
+  ScanStats scan(LogFilter const& filter, F&& f,
+                 Delivery delivery = Delivery::Ordered, unsigned threads = 0) const
+  {
+    if (!threads) threads = std::max(1u, std::thread::hardware_concurrency());
+    // more chunks than threads to balance load; small ones when ordered, to
+    // bound what waits in results
+    size_t n = threads * 4;
+    if (delivery == Delivery::Ordered) n = std::max(n, file_.size() / ORDERED_CHUNK);
+    auto chunks = split(n, threads);
+    size_t const window = ORDERED_WINDOW * threads;
+
+    std::vector<ScanStats> stats(chunks.size());
+    std::vector<std::vector<std::pair<Frame, Msg>>> results(
+      delivery == Delivery::Ordered ? chunks.size() : 0);
+    std::vector<char> ready(chunks.size(), 0);
+    std::mutex mtx;
+    std::condition_variable cv;     // a chunk is ready
+    std::condition_variable space;  // a chunk was delivered
+    std::atomic<size_t> next(0);
+    size_t delivered = 0;           // under mtx
+    bool stop = false;              // under mtx
+    std::exception_ptr error;       // first thrown on a worker, under mtx
+
+    auto halt = [&] {
+      {
+        std::lock_guard<std::mutex> lock(mtx);
+        stop = true;
+      }
+      cv.notify_all();
+      space.notify_all();
+    };
+
+    auto worker = [&] {
+      std::string buf;  // frame with '|' replaced by SOH
+      try {
+        for (size_t i; (i = next++) < chunks.size(); ) {
+          {
+            std::unique_lock<std::mutex> lock(mtx);
+            if (delivery == Delivery::Ordered)
+              space.wait(lock, [&] { return stop || i < delivered + window; });
+            if (stop) break;
+          }
+          std::vector<std::pair<Frame, Msg>> out;
+          scan_range(chunks[i].first, chunks[i].second, filter, stats[i],
+            [&](Frame const& fr) {
+              Msg msg;
+              if (!decode(fr, buf, msg)) { ++stats[i].errors; return; }
+              if (delivery == Delivery::Unordered) f(fr, msg);
+              else out.emplace_back(fr, std::move(msg));
+            });
+          if (delivery == Delivery::Ordered) {
+            std::lock_guard<std::mutex> lock(mtx);
+            results[i] = std::move(out);
+            ready[i] = 1;
+            cv.notify_one();
+          }
+        }
+      }
+      catch (...) {
+        {
+          std::lock_guard<std::mutex> lock(mtx);
+          if (!error) error = std::current_exception();
+        }
+        halt();
+      }
+    };
+
+    Joiner pool(halt);  // f throwing here stops and joins the workers too
+    for (unsigned t = 0; t < threads; ++t) pool.threads.emplace_back(worker);
+
+    if (delivery == Delivery::Ordered) {
+      for (size_t i = 0; i < chunks.size(); ++i) {
+        std::vector<std::pair<Frame, Msg>> out;
+        {
+          std::unique_lock<std::mutex> lock(mtx);
+          cv.wait(lock, [&] { return stop || ready[i] != 0; });
+          if (stop) break;
+          out = std::move(results[i]);
+          delivered = i + 1;
+        }
+        space.notify_all();
+        for (auto& r : out) f(r.first, r.second);
+      }
+    }
+
+    pool.join();
+    if (error) std::rethrow_exception(error);
+
+    ScanStats total;
+    for (auto const& s : stats) total += s;
+    return total;
+  }
+
+private:
+  enum { ORDERED_CHUNK = 4 << 20, ORDERED_WINDOW = 2 };  // bytes, chunks per thread
+
+  struct Joiner
+  // Joins the workers on every way out of scan(); stops them first unless
+  // join() was reached normally
+  {
+    explicit Joiner(std::function<void()> halt) : halt(std::move(halt)) {}
+    ~Joiner() {
+      if (!joined) halt();
+      join();
+    }
+
+    void join() {
+      for (auto& t : threads) if (t.joinable()) t.join();
+      joined = true;
+    }
+
+    std::vector<std::thread> threads;
+    std::function<void()> halt;
+    bool joined = false;
+  };
+
+  char detect_delim() const
+  // A SOH anywhere in the first frame means SOH, else '|'
+  {
+    char const* b = file_.data();
+    char const* e = b + std::min<size_t>(file_.size(), 4096);
+    return std::find(b, e, SOH) != e ? char(SOH) : '|';
+  }
+
+  typedef std::pair<char const*, char const*> Chunk;
+
+  std::vector<Chunk> split(size_t n, unsigned threads) const
+  // Chunks start where frames() finds a frame too.  Edges are first placed
+  // with find_frame from evenly spaced offsets, which may land on a frame
+  // embedded in a data field of a longer one.  So each chunk is walked, on
+  // threads, to where frames() would go on after it; where that is not the
+  // next chunk's start, the edge moves to where the two walks meet.
+  {
+    char const* b = file_.data();
+    char const* e = b + file_.size();
+    size_t step = file_.size() / n + 1;
+
+    std::vector<Chunk> chunks;
+    for (char const* p = b; p < e; ) {
+      char const* q = p + std::min<size_t>(step, e - p);
+      if (q < e) q = find_frame(q, e, delim_, b);
+      chunks.emplace_back(p, q);
+      p = q;
+    }
+
+    std::vector<char const*> after(chunks.size());  // next frame start past each chunk
+    std::atomic<size_t> next(0);
+    {
+      Joiner pool([] {});
+      for (unsigned t = 0; t < std::min<size_t>(threads, chunks.size()); ++t)
+        pool.threads.emplace_back([&] {
+          for (size_t i; (i = next++) < chunks.size(); )
+            after[i] = walk(chunks[i].first, chunks[i].second, [](char const*, size_t) {});
+        });
+      pool.join();
+    }
+
+    char const* a = after.empty() ? e : after[0];  // where frames() goes on
+    for (size_t i = 1; i < chunks.size(); ++i) {
+      char const* x = a;
+      char const* y = chunks[i].first;
+      while (x != y) {  // edge inside a frame: follow both until they meet
+        char const*& z = x < y ? x : y;
+        z = walk(z, z + 1, [](char const*, size_t) {});
+      }
+      chunks[i - 1].second = chunks[i].first = x;
+      if (x >= chunks[i].second) chunks[i].second = a = x;  // met past this chunk
+      else a = after[i];
+    }
+    return chunks;
+  }
+
+  template <typename F>
+  char const* walk(char const* p, char const* e, F&& f) const
+  // Calls f(frame, len) for each frame frames() finds starting in [p, e), and
+  // returns where the next one starts.  p is the file start, a frame start,
+  // or the end of a frame.
+  {
+    char const* b = file_.data();
+    char const* file_end = b + file_.size();
+    for (;;) {
+      size_t len = frame_length(p, file_end, delim_);
+      if (!len) {  // not a frame: search on from here
+        p = find_frame(p, file_end, delim_, b);
+        len = frame_length(p, file_end, delim_);
+      }
+      if (p >= e) return p;
+      f(p, len);
+      p += len;
+    }
+  }
+
+  template <typename F>
+  void scan_range(char const* p, char const* e, LogFilter const& filter,
+                  ScanStats& stats, F&& f) const
+  // Frames starting in [p, e); the last one may run past e
+  {
+    walk(p, e, [&](char const* fp, size_t len) {
+      Frame fr{fp, fp + len, delim_};
+      ++stats.frames;
+      if (filter(fr)) {
+        ++stats.matched;
+        f(fr);
+      }
+    });
+  }
+
+  template <typename Msg>
+  static bool decode(Frame const& fr, std::string& buf, Msg& msg)
+  {
+    if (fr.delim == SOH) {
+      char const* b = fr.begin;
+      return msg.decode(b, fr.end);
+    }
+    buf.assign(fr.begin, fr.end);
+    std::replace(buf.begin(), buf.end(), fr.delim, char(SOH));
+    char const* b = buf.data();
+    return msg.decode(b, b + buf.size());
+  }
+
+  MappedFile file_;
+  char delim_;
+};
+
+}  // namespace FIX
+
+#endif
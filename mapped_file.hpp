@@ -0,0 +1,55 @@
+#ifndef FIX_MAPPED_FILE_HPP_
+#define FIX_MAPPED_FILE_HPP_
+
+#include <stdexcept>  // std::runtime_error
+#include <string>
+
+#include <fcntl.h>    // open
+#include <sys/mman.h> // mmap, madvise
+#include <sys/stat.h> // fstat
+#include <unistd.h>   // close
+
+namespace FIX {
+
+class MappedFile
+// Read-only mapping of a whole file
+{
+public:
+  explicit MappedFile(char const* path) {
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) throw std::runtime_error(std::string("Cannot open ") + path);
+    struct stat st;
+    if (::fstat(fd, &st) < 0) {
+      ::close(fd);
+      throw std::runtime_error(std::string("Cannot stat ") + path);
+    }
+    size_ = st.st_size;
+    if (size_) {
+      void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p == MAP_FAILED) {
+        ::close(fd);
+        throw std::runtime_error(std::string("Cannot mmap ") + path);
+      }
+      data_ = static_cast<char const*>(p);
+      ::madvise(p, size_, MADV_SEQUENTIAL);
+      ::madvise(p, size_, MADV_WILLNEED);
+    }
+    ::close(fd);  // the mapping stays valid
+  }
+
+  ~MappedFile() { if (data_) ::munmap(const_cast<char*>(data_), size_); }
+
+  MappedFile(MappedFile const&) = delete;
+  MappedFile& operator=(MappedFile const&) = delete;
+
+  char const* data() const { return data_; }
+  size_t size() const { return size_; }
+
+private:
+  char const* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+}  // namespace FIX
+
+#endif
@@ -3,8 +3,15 @@
 
 #include "dict.hpp"
 #include "combine_tuples.hpp"
+#include "wire.hpp"
 #include <boost/container/static_vector.hpp>  // nice replacement for char[N]
+#include <boost/variant.hpp>
+#include <algorithm> // std::min
 #include <iterator> // for back_insert_iterator
+#include <numeric>  // std::accumulate
+#if __cplusplus > 201703L && __has_include(<span>)
+#include <span>
+#endif
 
 namespace FIX {
 
@@ -14,8 +21,11 @@ class Group
 // Message itself is a group.
 // So a group can contain groups.
 {
+public:
   typedef typename pl::tuple_cat_result<
     typename Field::type, typename Fields::type...>::type type; // type is a tuple
+
+private:
   type data_;
 
 public:
@@ -48,6 +58,8 @@ public:
 
   template <typename F> F& at() { return std::get<F>(data_); } 
   template <typename F> F const& get() const { return std::get<F>(data_); }
+  type const& fields() const { return data_; }  // nested groups are flattened
+  type& fields() { return data_; }
 
 private:
   template <typename Iterator, size_t N>
@@ -63,18 +75,23 @@ private:
   }
 };
 
-template <typename F, typename G> inline F& at(G& g) { return g.at<F>(); }
-template <typename F, typename G> inline F const& at(G const& g) { return g.at<F>(); }
+template <typename F, typename G> inline F& at(G& g) { return g.template at<F>(); }
+template <typename F, typename G> inline F const& at(G const& g) { return g.template get<F>(); }
 
  
 template <typename Field, typename... Fields>
 // Field is type of NoXXXXXX, indicating number of groups
 class RepeatGroup 
 {
+public:
   enum { tag = Field::tag }; // make it like a normal Field
   typedef RepeatGroup<Field, Fields...> type;
   typedef Group<Fields...> group_type;
 
+  std::vector<group_type> const& groups() const { return groups_; }
+  std::vector<group_type>& groups() { return groups_; }
+
+private:
   Field no_field_;
   std::vector<group_type> groups_;
 
@@ -130,7 +147,9 @@ using Header = Group<
 template <typename InIterator, typename OutIterator> inline
 void calc_checksum(InIterator begin, InIterator end, OutIterator& out) 
 {
-  uint8_t cs = std::accumulate(begin, end, static_cast<uint8_t>(0));
+  // summed wide, then mod 256: the loop vectorizes
+  uint8_t cs = std::accumulate(begin, end, 0u,
+                               [](unsigned s, unsigned char c) { return s + c; });
   *out++ = cs / 100 + '0';
   *out++ = cs / 10 % 10 + '0';
   *out   = cs % 10 + '0';
@@ -158,7 +177,7 @@ struct Message : Group<Header, Fields...>
   typedef MsgTypeType msg_type_type;
   typedef Group<Header, Fields...> base_type;
 
-  Message() { at<MsgType>() = MsgTypeType().value(); }
+  Message() { this->template at<MsgType>() = MsgTypeType().value(); }
 
   template <typename Iterator>  // For receiving something
   Message(Iterator& begin, Iterator end) { 
@@ -168,9 +187,10 @@ struct Message : Group<Header, Fields...>
   template <typename Container>  // For receiving something
   Message(Container const& str) : Message(str.begin(), str.end()) {}
 
-  std::string const& msgType() const { return at<MsgType>().value(); }
+  std::string const& msgType() const { return this->template get<MsgType>().value(); }
 
-  template <typename Container>  // vector, static_vector, string, etc. 
+  template <typename Container,  // vector, static_vector, string, etc.
+            typename = decltype(std::declval<Container&>().clear())>  // not arrays, spans
   void encode(Container& str) 
   {
     str.clear();
@@ -190,6 +210,67 @@ struct Message : Group<Header, Fields...>
     checksum_.encode(back_insert_iterator(str)); 
   } 
 
+  //---------------------------------------------------------------------------
+  // Encoding into a caller-supplied buffer: stack array, ring slot, registered
+  // I/O buffer.  Returns the length written; throws std::length_error if the
+  // buffer is too small or a value is over its capacity (see wire.hpp).
+  // A buffer of max_size bytes always fits and is written without checks.
+  //---------------------------------------------------------------------------
+  static constexpr size_t max_body = wire::max_tuple_size<typename base_type::type>::value;
+  static constexpr size_t max_size =
+    max_body == wire::UNBOUNDED || capacity<BeginString>::value == 0 ? wire::UNBOUNDED
+    : 2 + capacity<BeginString>::value + 1 + 2 + wire::digits(max_body) + 1 + max_body
+      + 3 + CHECKSUM_SIZE;
+
+  size_t encode(char* buf, size_t size) const
+  {
+    enum { LENGTH_DIGITS = max_body == wire::UNBOUNDED ? 10 : wire::digits(max_body),
+           TRAILER = 3 + CHECKSUM_SIZE };  // 10=nnn|
+
+    std::string const& begstr = very_header_.get<BeginString>().value();
+    if (capacity<BeginString>::value != 0 && begstr.size() > capacity<BeginString>::value)
+      wire::over_capacity(BeginString::tag);
+
+    // body first, after room for the longest 8=...|9=...|
+    size_t digits = std::min<size_t>(LENGTH_DIGITS, wire::digits(size));
+    size_t room = 2 + begstr.size() + 1 + 2 + digits + 1;
+    if (size < room + TRAILER) wire::buffer_full();
+    char* body = buf + room;
+    char* p = body;
+    char* e = buf + size - TRAILER;
+    if (size >= max_size)
+      wire::put_fields<false>(this->fields(), p, e);
+    else {  // BodyLength may come out shorter than digits, its spare room going to the body
+      e = std::min(buf + size, e + digits - 1);
+      wire::put_fields<true>(this->fields(), p, e);
+    }
+    size_t body_len = p - body;
+
+    // then the real header, and the body moved up against it
+    p = buf;
+    wire::put<false>(p, e, "8=", 2);
+    wire::put<false>(p, e, begstr.data(), begstr.size());
+    wire::put<false>(p, e, "\x01" "9=", 3);
+    wire::put_number<false, LENGTH_DIGITS>(p, e, body_len, BodyLength::tag);
+    *p++ = '\x01';
+    if (p != body) std::memmove(p, body, body_len);
+    p += body_len;
+    if (size_t(buf + size - p) < TRAILER) wire::buffer_full();
+
+    char* cs = p + 3;
+    std::memcpy(p, "10=", 3);
+    calc_checksum(buf, p, cs);
+    p[TRAILER - 1] = '\x01';
+    return p + TRAILER - buf;
+  }
+
+  template <size_t N>
+  size_t encode(char (&buf)[N]) const { return encode(buf, N); }
+
+#ifdef __cpp_lib_span
+  size_t encode(std::span<char> buf) const { return encode(buf.data(), buf.size()); }
+#endif
+
   template <typename Container>
   bool decode(Container const& str)
   {
@@ -206,7 +287,7 @@ struct Message : Group<Header, Fields...>
         begin == e &&                    // else some fields unrevolved
         checksum_.decode(begin, end))    // checksum resolved
     { 
-      char cs[checksum_sz];
+      char cs[CHECKSUM_SIZE];
       calc_checksum(b, end, cs);
       if (std::equal(cs, cs+CHECKSUM_SIZE-1, checksum_.value().begin())) // checksum ok
         return true;
@@ -257,7 +338,7 @@ struct GenericMessage : boost::variant<Message, Messages...>
 
     auto b = begin;
     if (very_header.decode(b, end) && msg_type.decode(b, end)) {
-      if (msg_type_.value() == Message::msg_type_type().value()) {
+      if (msg_type.value() == Message::msg_type_type().value()) {
         *this = Message();
         decode_visitor<Iterator> visitor(begin, end);
         return apply_visitor(visitor, *this);
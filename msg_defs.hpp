@@ -44,6 +44,9 @@ using compDisclosureInstructionGrp = RepeatGroup<
   , DisclosureInstruction
 >;
 
+DEF_CAPACITY(compParties, 8)
+DEF_CAPACITY(compDisclosureInstructionGrp, 8)
+
 using Logon = 
   Message<mtLogon
     , EncryptMethod
@@ -0,0 +1,308 @@
+#ifndef FIX_RISK_HPP_
+#define FIX_RISK_HPP_
+
+// Inline pre-trade risk checks for NewOrder, run before the order is encoded.
+//
+// Limits and running exposure live in cache-line aligned slots, one per
+// instrument and one per account, updated with atomics only, so any number
+// of sending threads can check orders at once.  The stateless checks are a
+// compile-time list of policy types (no virtual calls); a limit of 0 turns
+// its check off for that slot.  Exposure and credit are reserved last and
+// rolled back if a later step rejects.
+//
+// Usage:
+//   StandardRiskEngine risk;                // or RiskEngine<MaxQtyCheck> etc.
+//   InstrumentLimits l;
+//   l.ref_price = 300; l.band = 0.05; l.max_qty = 1e5;
+//   risk.add_instrument("700", l);
+//   risk.add_account("ACC1", 5e7);
+//   // trading starts; add_* must not be called from here on
+//   RiskTicket t;                           // kept with the live order
+//   if (risk.check(order, t) == RiskResult::Accept) send(order);
+//   ...
+//   risk.release(t, last_qty);              // on a fill of an accepted order
+//   risk.release(t);                        // on its cancel, or a reject by the venue
+
+#include "msg_defs.hpp"
+#include <atomic>
+#include <cmath>      // std::isfinite
+#include <stdexcept>  // std::length_error
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace FIX {
+
+enum class RiskResult
+{
+  Accept,
+  BadQtyOrPrice,  // qty not > 0, or a price not finite and > 0
+  UnknownInstrument,
+  UnknownAccount,
+  NoPrice,        // limit order without price, and no reference price
+  PriceBand,
+  MaxQty,
+  MaxNotional,
+  Exposure,       // instrument open notional
+  Credit          // account open notional
+};
+
+enum { RISK_CACHE_LINE = 64 };
+
+struct InstrumentLimits
+{
+  double ref_price    = 0;  // for the band, and to value market orders
+  double band         = 0;  // allowed |price - ref| / ref
+  double max_qty      = 0;  // per order
+  double max_notional = 0;  // per order
+  double max_exposure = 0;  // open notional over all orders
+};
+
+namespace risk {
+
+template <typename T>
+struct Relaxed : std::atomic<T>
+// Limit that may be changed while trading
+{
+  Relaxed(T v = T()) : std::atomic<T>(v) {}
+  operator T() const { return this->load(std::memory_order_relaxed); }
+  Relaxed& operator=(T v) { this->store(v, std::memory_order_relaxed); return *this; }
+};
+
+inline bool reserve(std::atomic<double>& used, double amount, double limit)
+// Adds amount unless that takes used over limit (0 = no limit)
+{
+  double cur = used.load(std::memory_order_relaxed);
+  do {
+    if (limit > 0 && cur + amount > limit) return false;
+  } while (!used.compare_exchange_weak(cur, cur + amount, std::memory_order_relaxed));
+  return true;
+}
+
+inline void unreserve(std::atomic<double>& used, double amount)
+{
+  double cur = used.load(std::memory_order_relaxed);
+  while (!used.compare_exchange_weak(cur, cur - amount, std::memory_order_relaxed)) ;
+}
+
+}  // namespace risk
+
+struct alignas(RISK_CACHE_LINE) InstrumentSlot
+{
+  risk::Relaxed<double> ref_price, band, max_qty, max_notional, max_exposure;
+  alignas(RISK_CACHE_LINE) std::atomic<double> exposure{0};  // written by every order
+
+  void set(InstrumentLimits const& l) {
+    ref_price = l.ref_price; band = l.band; max_qty = l.max_qty;
+    max_notional = l.max_notional; max_exposure = l.max_exposure;
+  }
+};
+
+struct alignas(RISK_CACHE_LINE) AccountSlot
+{
+  risk::Relaxed<double> credit_limit;
+  alignas(RISK_CACHE_LINE) std::atomic<double> used{0};
+};
+
+struct RiskTicket
+// What check() reserved for an accepted order, so release() gives back exactly
+// that however the limits or reference price have moved since
+{
+  enum : uint32_t { NONE = ~uint32_t(0) };
+
+  uint32_t instrument = NONE;  // slot indices; NONE: nothing held
+  uint32_t account    = NONE;  // NONE also when the order has no account
+  double qty      = 0;         // still held
+  double notional = 0;
+
+  explicit operator bool() const { return instrument != NONE; }
+};
+
+struct RiskOrder
+// The NewOrder fields the checks look at
+{
+  std::string const* security_id;
+  std::string const* account;  // nullptr if the order has no account party
+  char   side;
+  double qty;
+  double price;                // limit price, or the reference price
+  bool   has_price;
+  double notional;             // qty * price
+};
+
+
+// Stateless checks: static RiskResult check(RiskOrder const&, InstrumentSlot const&)
+
+struct PriceBandCheck
+{
+  static RiskResult check(RiskOrder const& o, InstrumentSlot const& s) {
+    double ref = s.ref_price, band = s.band;
+    if (!o.has_price || band <= 0 || ref <= 0) return RiskResult::Accept;
+    double diff = o.price > ref ? o.price - ref : ref - o.price;
+    return diff > ref * band ? RiskResult::PriceBand : RiskResult::Accept;
+  }
+};
+
+struct MaxQtyCheck
+{
+  static RiskResult check(RiskOrder const& o, InstrumentSlot const& s) {
+    double max = s.max_qty;
+    return max > 0 && o.qty > max ? RiskResult::MaxQty : RiskResult::Accept;
+  }
+};
+
+struct MaxNotionalCheck
+{
+  static RiskResult check(RiskOrder const& o, InstrumentSlot const& s) {
+    double max = s.max_notional;
+    return max > 0 && o.notional > max ? RiskResult::MaxNotional : RiskResult::Accept;
+  }
+};
+
+
+template <typename... Checks>
+class RiskEngine
+{
+public:
+  // PartyRole of the party carrying the account; 0 takes the first party
+  explicit RiskEngine(int account_role = 0, size_t max_instruments = 4096,
+                      size_t max_accounts = 1024)
+    : account_role_(account_role), instruments_(max_instruments), accounts_(max_accounts) {}
+
+  //---------------------------------------------------------------------------
+  // Set up, before trading.  Limits of existing entries can be changed at any
+  // time through instrument()/account().
+  //---------------------------------------------------------------------------
+  InstrumentSlot& add_instrument(std::string const& id, InstrumentLimits const& l)
+  {
+    auto it = instrument_ids_.find(id);
+    if (it == instrument_ids_.end()) {
+      if (instrument_ids_.size() == instruments_.size())
+        throw std::length_error("Too many instruments");
+      it = instrument_ids_.emplace(id, instrument_ids_.size()).first;
+    }
+    instruments_[it->second].set(l);
+    return instruments_[it->second];
+  }
+
+  AccountSlot& add_account(std::string const& id, double credit_limit)
+  {
+    auto it = account_ids_.find(id);
+    if (it == account_ids_.end()) {
+      if (account_ids_.size() == accounts_.size())
+        throw std::length_error("Too many accounts");
+      it = account_ids_.emplace(id, account_ids_.size()).first;
+    }
+    accounts_[it->second].credit_limit = credit_limit;
+    return accounts_[it->second];
+  }
+
+  InstrumentSlot* instrument(std::string const& id) {
+    auto it = instrument_ids_.find(id);
+    return it == instrument_ids_.end() ? nullptr : &instruments_[it->second];
+  }
+
+  AccountSlot* account(std::string const& id) {
+    auto it = account_ids_.find(id);
+    return it == account_ids_.end() ? nullptr : &accounts_[it->second];
+  }
+
+  //---------------------------------------------------------------------------
+  // Hot path.  On Accept the order's notional is held against the instrument
+  // and account, and recorded in t, until released; otherwise t is empty.
+  //---------------------------------------------------------------------------
+  RiskResult check(NewOrder const& order, RiskTicket& t) { return check(view(order), t); }
+
+  RiskResult check(RiskOrder const& o, RiskTicket& t)
+  {
+    t = RiskTicket();
+    // NaN would poison exposure (NaN > limit is false), negatives free room
+    if (!(o.qty > 0 && std::isfinite(o.qty)) ||
+        (o.has_price && !(o.price > 0 && std::isfinite(o.price))))
+      return RiskResult::BadQtyOrPrice;
+    auto ii = instrument_ids_.find(*o.security_id);
+    if (ii == instrument_ids_.end()) return RiskResult::UnknownInstrument;
+    InstrumentSlot& ins = instruments_[ii->second];
+
+    AccountSlot* acc = nullptr;
+    if (o.account) {
+      auto ai = account_ids_.find(*o.account);
+      if (ai == account_ids_.end()) return RiskResult::UnknownAccount;
+      acc = &accounts_[ai->second];
+    }
+
+    RiskOrder ov = o;
+    if (!ov.has_price) {  // market order: value at the reference price
+      ov.price = ins.ref_price;
+      if (!(ov.price > 0 && std::isfinite(ov.price))) return RiskResult::NoPrice;
+    }
+    ov.notional = ov.qty * ov.price;
+    if (!std::isfinite(ov.notional)) return RiskResult::BadQtyOrPrice;
+
+    RiskResult r = RiskResult::Accept;
+    // first failing check wins; the rest are skipped
+    ((r == RiskResult::Accept ? void(r = Checks::check(ov, ins)) : void()), ...);
+    if (r != RiskResult::Accept) return r;
+
+    if (!risk::reserve(ins.exposure, ov.notional, ins.max_exposure))
+      return RiskResult::Exposure;
+    if (acc && !risk::reserve(acc->used, ov.notional, acc->credit_limit)) {
+      risk::unreserve(ins.exposure, ov.notional);
+      return RiskResult::Credit;
+    }
+    t.instrument = ii->second;
+    if (acc) t.account = uint32_t(acc - accounts_.data());
+    t.qty = ov.qty;
+    t.notional = ov.notional;
+    return RiskResult::Accept;
+  }
+
+  // Gives back qty's share of what t holds (all of it by default), and takes
+  // it off t; t is empty once all is released.
+  void release(RiskTicket& t, double qty = -1)
+  {
+    if (!t) return;
+    double notional = t.notional;
+    if (qty >= 0 && qty < t.qty) notional *= qty / t.qty;
+    else qty = t.qty;
+
+    risk::unreserve(instruments_[t.instrument].exposure, notional);
+    if (t.account != RiskTicket::NONE) risk::unreserve(accounts_[t.account].used, notional);
+    t.qty -= qty;
+    t.notional -= notional;
+    if (t.qty <= 0) t = RiskTicket();
+  }
+
+  RiskOrder view(NewOrder const& order) const
+  {
+    RiskOrder o;
+    o.security_id = &order.get<SecurityId>().value();
+    o.side = order.get<Side>().value();
+    o.qty = order.get<OrderQty>().value();
+    auto const& px = order.get<Optional<Price0>>();
+    o.has_price = bool(px);
+    o.price = px ? px->value() : 0;
+    o.notional = o.qty * o.price;
+
+    o.account = nullptr;
+    for (auto const& p : order.get<compParties>().groups())
+      if (!account_role_ || p.get<PartyRole>().value() == account_role_) {
+        o.account = &p.get<PartyId>().value();
+        break;
+      }
+    return o;
+  }
+
+private:
+  int account_role_;
+  std::unordered_map<std::string, uint32_t> instrument_ids_;
+  std::unordered_map<std::string, uint32_t> account_ids_;
+  std::vector<InstrumentSlot> instruments_;  // never resized: slots stay put
+  std::vector<AccountSlot> accounts_;
+};
+
+using StandardRiskEngine = RiskEngine<PriceBandCheck, MaxQtyCheck, MaxNotionalCheck>;
+
+}  // namespace FIX
+
+#endif
@@ -0,0 +1,209 @@
+#ifndef FIX_ROUTER_HPP_
+#define FIX_ROUTER_HPP_
+
+// Pass-through header rewrite for routers and drop-copy fan-out.
+//
+// Only the standard header of a raw frame is looked at; the body is copied
+// as is and never parsed, so any MsgType works, typed or not.  BodyLength
+// and CheckSum are fixed from the bytes that changed, not recomputed over
+// the whole message.  With '|' frames (logs) the CheckSum is still that of
+// the SOH wire bytes, so delimiters are summed as SOH.
+//
+// apply() reuses scratch buffers held in the HeaderRewrite, so it is not
+// const: one instance per thread.
+//
+// Usage:
+//   HeaderRewrite rw;
+//   rw.set<SenderCompId>("GW1").set<TargetCompId>("EXCH").set<OnBehalfOfCompId>(client);
+//   ...
+//   rw.set<MsgSeqNum>(++out_seq).set<SendingTime>(now);
+//   rw.apply(frame, out);   // frame from a Framer, LogReader, ...
+
+#include "dict.hpp"
+#include "frame.hpp"
+#include <algorithm>   // std::binary_search
+#include <charconv>    // std::to_chars
+#include <cstdio>      // snprintf
+#include <iterator>    // std::begin, std::end
+#include <string>
+#include <vector>
+
+namespace FIX {
+
+inline bool is_header_tag(uint tag)
+// Tags of the FIX standard header
+{
+  static uint const tags[] = {   // sorted
+    8, 9, 34, 35, 43, 49, 50, 52, 56, 57, 90, 91, 97, 115, 116, 122, 128, 129,
+    142, 143, 144, 145, 212, 213, 347, 369, 370, 627, 628, 629, 630, 1128, 1129, 1156
+  };
+  return std::binary_search(std::begin(tags), std::end(tags), tag);
+}
+
+namespace detail {
+
+inline unsigned byte_sum(char const* b, char const* e) {
+  unsigned s = 0;
+  for (; b != e; ++b) s += static_cast<unsigned char>(*b);
+  return s;
+}
+
+inline unsigned byte_sum(std::string_view s) { return byte_sum(s.data(), s.data() + s.size()); }
+
+inline unsigned field_sum(char const* b, char const* e, char delim)
+// Sum of "tag=value<delim>" as sent, i.e. with the delimiter as SOH
+{
+  return byte_sum(b, e) - static_cast<unsigned char>(delim) + SOH;
+}
+
+template <typename T>
+inline std::string to_fix(T const& v)  // value text as on the wire
+{
+  if constexpr (std::is_same<T, std::string>::value) return v;
+  else if constexpr (std::is_same<T, bool>::value) return v ? "Y" : "N";
+  else if constexpr (std::is_same<T, char>::value) return std::string(1, v);
+  else if constexpr (std::is_floating_point<T>::value) {
+    char buf[32];
+    return std::string(buf, std::snprintf(buf, sizeof(buf), "%.15g", v));
+  }
+  else return std::to_string(v);
+}
+
+}  // namespace detail
+
+
+class HeaderRewrite
+{
+public:
+  // Replaces tag in the header, or adds it at the end of the header
+  HeaderRewrite& set(uint tag, std::string_view value)
+  {
+    for (auto& e : edits_)
+      if (e.tag == tag) { e.value.assign(value.data(), value.size()); e.remove = false; return *this; }
+    edits_.push_back(Edit{tag, std::string(value), false});
+    return *this;
+  }
+
+  // Typed: v is converted to the field's value type first
+  template <typename F, typename U>
+  HeaderRewrite& set(U const& v)
+  {
+    typedef typename std::decay<decltype(std::declval<F const&>().value())>::type T;
+    return set(F::tag, detail::to_fix(T(v)));
+  }
+
+  HeaderRewrite& remove(uint tag)
+  {
+    set(tag, std::string_view());
+    edits_[find(tag)].remove = true;
+    return *this;
+  }
+
+  HeaderRewrite& clear() { edits_.clear(); return *this; }
+
+  //---------------------------------------------------------------------------
+  // Writes the rewritten frame into out.  Returns false, leaving out empty, if
+  // in is not a complete frame, or an edit targets BeginString, BodyLength,
+  // MsgType or CheckSum.
+  //---------------------------------------------------------------------------
+  bool apply(Frame const& in, std::string& out)
+  {
+    out.clear();
+    for (auto const& e : edits_)
+      if (e.tag == 8 || e.tag == 9 || e.tag == 10 || e.tag == 35) return false;
+    size_t len;
+    if (check_frame(in.begin, in.end, len, in.delim) != FrameStatus::Complete) return false;
+    char const d = in.delim;
+
+    // 8=...|9=N| then the header, body and trailer
+    char const* bl = static_cast<char const*>(std::memchr(in.begin, d, len)) + 1;  // "9="
+    char const* body = static_cast<char const*>(std::memchr(bl, d, in.begin + len - bl)) + 1;
+    char const* trailer = in.begin + len - TRAILER_SIZE;
+
+    std::vector<char>& done = done_;
+    done.assign(edits_.size(), 0);
+    std::string& head = head_;  // rewritten header fields, after 9=N|
+    head.clear();
+    head.reserve(HEADER_RESERVE);
+    long delta = 0;     // change in BodyLength
+    unsigned sub = 0, add = 0;  // byte sums of removed and added text
+
+    char const* p = body;
+    while (p < trailer) {
+      char const* v = p;
+      size_t tag;
+      if (!detail::parse_uint(v, trailer, '=', tag) || !is_header_tag(tag)) break;
+      char const* f_end = static_cast<char const*>(std::memchr(v, d, trailer - v)) + 1;
+
+      int i = find(tag);
+      if (i < 0) head.append(p, f_end);
+      else {
+        done[i] = 1;
+        sub += detail::field_sum(p, f_end, d);
+        delta -= f_end - p;
+        if (!edits_[i].remove) emit(edits_[i], d, head, add, delta);
+      }
+      p = f_end;
+    }
+
+    for (size_t i = 0; i < edits_.size(); ++i)  // tags not there yet
+      if (!done[i] && !edits_[i].remove) emit(edits_[i], d, head, add, delta);
+
+    // BodyLength
+    std::string_view old_len(bl + 2, body - 1 - (bl + 2));
+    char len_buf[24];
+    std::string_view new_len(len_buf,
+      std::to_chars(len_buf, len_buf + sizeof(len_buf), (trailer - body) + delta).ptr - len_buf);
+    sub += detail::byte_sum(old_len);
+    add += detail::byte_sum(new_len);
+
+    unsigned old_cs = (trailer[3] - '0') * 100 + (trailer[4] - '0') * 10 + (trailer[5] - '0');
+    unsigned cs = (old_cs + add - sub) % 256;
+
+    out.reserve(len + head.size());
+    out.append(in.begin, bl + 2);
+    out += new_len;
+    out += d;
+    out += head;
+    out.append(p, trailer);  // body, untouched
+    char tr[TRAILER_SIZE] = { '1', '0', '=', char('0' + cs / 100), char('0' + cs / 10 % 10),
+                              char('0' + cs % 10), d };
+    out.append(tr, TRAILER_SIZE);
+    return true;
+  }
+
+private:
+  enum { HEADER_RESERVE = 256 };
+
+  struct Edit
+  {
+    uint tag;
+    std::string value;
+    bool remove;
+  };
+
+  int find(size_t tag) const {
+    for (size_t i = 0; i < edits_.size(); ++i) if (edits_[i].tag == tag) return i;
+    return -1;
+  }
+
+  static void emit(Edit const& e, char d, std::string& head, unsigned& add, long& delta)
+  {
+    size_t start = head.size();
+    char tag[12];
+    head.append(tag, std::to_chars(tag, tag + sizeof(tag), e.tag).ptr);
+    head += '=';
+    head += e.value;
+    head += d;
+    add += detail::field_sum(head.data() + start, head.data() + head.size(), d);
+    delta += head.size() - start;
+  }
+
+  std::vector<Edit> edits_;
+  std::vector<char> done_;  // apply() scratch
+  std::string head_;
+};
+
+}  // namespace FIX
+
+#endif
@@ -0,0 +1,426 @@
+#ifndef FIX_SHM_TRANSPORT_HPP_
+#define FIX_SHM_TRANSPORT_HPP_
+
+// Shared-memory transport from strategy processes to one gateway process.
+//
+// A segment (shm_open'ed by name, or a memfd passed down to children) holds
+// one single-producer/single-consumer byte ring per producer.  Each record is
+// an encoded message (tag=value or binary.hpp) or an 8-byte prepared-message
+// handle.  The gateway polls all rings and hands records, in place, to its
+// outbound path.
+//
+// WaitMode::BusyPoll  the gateway spins; lowest latency, burns a core.
+// WaitMode::Futex     the gateway sleeps on a futex in the segment after a
+//                     short spin, and producers wake it when it is asleep.
+//
+// Usage:
+//   // gateway
+//   ShmSegment seg = ShmSegment::create("/fix_gw", 16, 1 << 20);
+//   ShmGateway gw(seg, WaitMode::Futex);
+//   gw.run([&](uint32_t ring, ShmRecord kind, std::string_view msg) { send(msg); }, stop);
+//
+//   // strategy
+//   ShmSegment seg = ShmSegment::open("/fix_gw");
+//   ShmProducer out(seg, WaitMode::Futex);
+//   order.encode(buf);
+//   while (!out.send(buf)) ;  // ring full for now; throws if buf can never fit
+//
+// A producer holds its ring through an OFD lock on one byte of the segment,
+// taken on a file description of its own, so the kernel frees the ring when
+// the producer exits or dies, whatever its pid namespace.
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>     // memcpy
+#include <stdexcept>   // std::runtime_error, std::length_error
+#include <string>
+#include <string_view>
+
+#include <fcntl.h>        // O_* constants, F_OFD_SETLK
+#include <linux/futex.h>  // FUTEX_WAIT, FUTEX_WAKE
+#include <sys/mman.h>     // shm_open, mmap, memfd_create
+#include <sys/syscall.h>  // SYS_futex
+#include <sys/stat.h>
+#include <unistd.h>       // ftruncate, close
+
+namespace FIX {
+
+enum class WaitMode { BusyPoll, Futex };
+
+enum class ShmRecord : uint16_t { Text = 1, Binary = 2, Handle = 3, Padding = 0xffff };
+
+enum { CACHE_LINE = 64 };
+
+namespace shm {
+
+enum : uint32_t { MAGIC = 0x46495853 };  // "FIXS"
+enum { VERSION = 1, IDLE_SPINS = 4096 };
+
+struct RecordHeader
+{
+  uint32_t length;  // payload bytes
+  ShmRecord kind;
+  uint16_t reserved;
+};
+
+struct alignas(CACHE_LINE) RingHeader
+{
+  alignas(CACHE_LINE) std::atomic<uint64_t> head;   // bytes written, by the producer
+  alignas(CACHE_LINE) std::atomic<uint64_t> tail;   // bytes consumed, by the gateway
+  alignas(CACHE_LINE) std::atomic<uint32_t> owner;  // pid of the attached producer, for
+                                                    // diagnostics; the OFD lock decides
+};
+
+struct alignas(CACHE_LINE) SegmentHeader
+{
+  uint32_t magic;
+  uint32_t version;
+  uint32_t num_rings;
+  uint32_t ring_bytes;  // power of 2
+  alignas(CACHE_LINE) std::atomic<uint32_t> wake_seq;  // futex word
+  std::atomic<uint32_t> sleeping;                      // gateway is (about to be) in FUTEX_WAIT
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free &&
+              std::atomic<uint32_t>::is_always_lock_free,
+              "atomics in shared memory must be lock free");
+
+inline size_t align8(size_t n) { return (n + 7) & ~size_t(7); }
+
+inline long futex(std::atomic<uint32_t>* addr, int op, uint32_t val) {
+  // not FUTEX_PRIVATE_FLAG: the word is shared between processes
+  return ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), op, val, nullptr, nullptr, 0);
+}
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#endif
+}
+
+}  // namespace shm
+
+
+class ShmSegment
+// Mapping of the shared segment; movable, unmapped on destruction
+{
+public:
+  // Gateway side: creates (or truncates) a named segment
+  static ShmSegment create(char const* name, uint32_t num_rings, uint32_t ring_bytes) {
+    int fd = ::shm_open(name, O_CREAT | O_RDWR | O_TRUNC, 0600);
+    if (fd < 0) throw std::runtime_error(std::string("Cannot shm_open ") + name);
+    return ShmSegment(fd, num_rings, ring_bytes);
+  }
+
+  // Gateway side: anonymous segment; pass fd() to producers via fork or SCM_RIGHTS
+  static ShmSegment create_anonymous(uint32_t num_rings, uint32_t ring_bytes) {
+    int fd = ::memfd_create("fix_shm", MFD_CLOEXEC);
+    if (fd < 0) throw std::runtime_error("Cannot memfd_create");
+    return ShmSegment(fd, num_rings, ring_bytes);
+  }
+
+  // Producer side
+  static ShmSegment open(char const* name) {
+    int fd = ::shm_open(name, O_RDWR, 0);
+    if (fd < 0) throw std::runtime_error(std::string("Cannot shm_open ") + name);
+    return ShmSegment(fd);
+  }
+
+  explicit ShmSegment(int fd) : fd_(fd) {  // attach to an initialised segment
+    struct stat st;
+    if (::fstat(fd_, &st) < 0 || size_t(st.st_size) < sizeof(shm::SegmentHeader)) {
+      ::close(fd_);
+      throw std::runtime_error("Bad shared memory segment");
+    }
+    map(st.st_size);
+    if (header()->magic != shm::MAGIC || header()->version != shm::VERSION ||
+        size_ != segment_size(header()->num_rings, header()->ring_bytes)) {
+      ::munmap(base_, size_);
+      ::close(fd_);
+      throw std::runtime_error("Bad shared memory segment");
+    }
+  }
+
+  ShmSegment(ShmSegment&& s) : fd_(s.fd_), base_(s.base_), size_(s.size_) {
+    s.fd_ = -1;
+    s.base_ = nullptr;
+  }
+
+  ShmSegment(ShmSegment const&) = delete;
+  ShmSegment& operator=(ShmSegment const&) = delete;
+
+  ~ShmSegment() {
+    if (base_) ::munmap(base_, size_);
+    if (fd_ >= 0) ::close(fd_);
+    base_ = nullptr;
+    fd_ = -1;
+  }
+
+  int fd() const { return fd_; }
+  uint32_t num_rings() const { return header()->num_rings; }
+  uint32_t ring_bytes() const { return header()->ring_bytes; }
+
+  shm::SegmentHeader* header() const { return static_cast<shm::SegmentHeader*>(base_); }
+
+  shm::RingHeader* ring(uint32_t i) const {
+    return reinterpret_cast<shm::RingHeader*>(
+      static_cast<char*>(base_) + sizeof(shm::SegmentHeader) + i * ring_stride(ring_bytes()));
+  }
+
+  char* ring_data(uint32_t i) const {
+    return reinterpret_cast<char*>(ring(i)) + sizeof(shm::RingHeader);
+  }
+
+private:
+  ShmSegment(int fd, uint32_t num_rings, uint32_t ring_bytes) : fd_(fd) {
+    if (!num_rings || ring_bytes < 64 || (ring_bytes & (ring_bytes - 1))) {
+      ::close(fd_);
+      throw std::invalid_argument("ring_bytes must be a power of 2 and at least 64");
+    }
+    size_t size = segment_size(num_rings, ring_bytes);
+    if (::ftruncate(fd_, size) < 0) {
+      ::close(fd_);
+      throw std::runtime_error("Cannot size shared memory segment");
+    }
+    map(size);  // ftruncate zero-fills: all rings empty and unowned
+
+    auto h = header();
+    h->num_rings = num_rings;
+    h->ring_bytes = ring_bytes;
+    h->version = shm::VERSION;
+    std::atomic_thread_fence(std::memory_order_release);
+    h->magic = shm::MAGIC;
+  }
+
+  static size_t ring_stride(uint32_t ring_bytes) { return sizeof(shm::RingHeader) + ring_bytes; }
+
+  static size_t segment_size(uint32_t num_rings, uint32_t ring_bytes) {
+    return sizeof(shm::SegmentHeader) + size_t(num_rings) * ring_stride(ring_bytes);
+  }
+
+  void map(size_t size) {
+    void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (p == MAP_FAILED) {
+      ::close(fd_);
+      fd_ = -1;
+      throw std::runtime_error("Cannot mmap shared memory segment");
+    }
+    base_ = p;
+    size_ = size;
+  }
+
+  int fd_ = -1;
+  void* base_ = nullptr;
+  size_t size_ = 0;
+};
+
+
+class ShmProducer
+// Writer end of one ring; one per strategy thread
+{
+public:
+  ShmProducer(ShmSegment const& seg, WaitMode mode = WaitMode::BusyPoll)
+    : seg_(seg), mode_(mode), lock_fd_(reopen(seg)), index_(claim(seg, lock_fd_))
+  {
+    ring_ = seg.ring(index_);
+    data_ = seg.ring_data(index_);
+    mask_ = seg.ring_bytes() - 1;
+    head_ = ring_->head.load(std::memory_order_relaxed);
+    tail_cache_ = ring_->tail.load(std::memory_order_acquire);
+  }
+
+  ~ShmProducer() {
+    ring_->owner.store(0, std::memory_order_relaxed);
+    ::close(lock_fd_);  // releases the ring
+  }
+
+  ShmProducer(ShmProducer const&) = delete;
+  ShmProducer& operator=(ShmProducer const&) = delete;
+
+  uint32_t ring() const { return index_; }
+
+  // Returns false if the ring is full now; the caller retries or drops.
+  // Throws std::length_error for a record over max_record(), which never fits.
+  bool send(std::string_view msg, ShmRecord kind = ShmRecord::Text) {
+    return send(msg.data(), msg.size(), kind);
+  }
+
+  bool send(uint64_t handle) {  // prepared-message handle, meaning agreed with the gateway
+    return send(reinterpret_cast<char const*>(&handle), sizeof(handle), ShmRecord::Handle);
+  }
+
+  bool send(char const* p, size_t len, ShmRecord kind)
+  {
+    if (len > max_record()) throw std::length_error("Record larger than half the shared memory ring");
+    size_t need = sizeof(shm::RecordHeader) + shm::align8(len);
+    size_t cap = mask_ + 1;
+    size_t to_end = cap - (head_ & mask_);
+    size_t total = need <= to_end ? need : need + to_end;  // pad to the end and wrap
+
+    if (head_ + total - tail_cache_ > cap) {
+      tail_cache_ = ring_->tail.load(std::memory_order_acquire);
+      if (head_ + total - tail_cache_ > cap) return false;
+    }
+
+    if (need > to_end) {
+      write_header(head_, to_end - sizeof(shm::RecordHeader), ShmRecord::Padding);
+      head_ += to_end;
+    }
+    write_header(head_, len, kind);
+    std::memcpy(data_ + (head_ & mask_) + sizeof(shm::RecordHeader), p, len);
+    head_ += need;
+
+    ring_->head.store(head_, std::memory_order_release);
+    if (mode_ == WaitMode::Futex) wake();
+    return true;
+  }
+
+  // Largest payload: with its header, at most half the ring, so it always
+  // fits after padding to the end
+  size_t max_record() const { return (mask_ + 1) / 2 - sizeof(shm::RecordHeader); }
+
+private:
+  static int reopen(ShmSegment const& seg) {
+    // a description of our own: one shared through fork or dup would share
+    // its OFD locks too
+    std::string path = "/proc/self/fd/" + std::to_string(seg.fd());
+    int fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0) throw std::runtime_error("Cannot reopen shared memory segment");
+    return fd;
+  }
+
+  static uint32_t claim(ShmSegment const& seg, int lock_fd) {
+    for (uint32_t i = 0; i < seg.num_rings(); ++i) {
+      struct flock l = {};
+      l.l_type = F_WRLCK;
+      l.l_whence = SEEK_SET;
+      l.l_start = reinterpret_cast<char*>(seg.ring(i)) - reinterpret_cast<char*>(seg.header());
+      l.l_len = 1;
+      // free, or left by a producer that exited or died without detaching;
+      // what it published is still read by the gateway, we append after it
+      if (::fcntl(lock_fd, F_OFD_SETLK, &l) == 0) {
+        seg.ring(i)->owner.store(::getpid(), std::memory_order_relaxed);
+        return i;
+      }
+    }
+    ::close(lock_fd);
+    throw std::runtime_error("No free ring in shared memory segment");
+  }
+
+  void write_header(uint64_t pos, size_t len, ShmRecord kind) {
+    shm::RecordHeader h = { uint32_t(len), kind, 0 };
+    std::memcpy(data_ + (pos & mask_), &h, sizeof(h));
+  }
+
+  void wake() {
+    auto h = seg_.header();
+    // pairs with the gateway's fence between setting sleeping and re-polling
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (h->sleeping.load(std::memory_order_relaxed)) {
+      h->wake_seq.fetch_add(1, std::memory_order_release);
+      shm::futex(&h->wake_seq, FUTEX_WAKE, 1);
+    }
+  }
+
+  ShmSegment const& seg_;
+  WaitMode mode_;
+  int lock_fd_;      // holds the OFD lock on our ring
+  uint32_t index_;
+  shm::RingHeader* ring_;
+  char* data_;
+  uint64_t mask_;
+  uint64_t head_;
+  uint64_t tail_cache_;
+};
+
+
+class ShmGateway
+// Reader of all rings; exactly one per segment
+{
+public:
+  ShmGateway(ShmSegment const& seg, WaitMode mode = WaitMode::BusyPoll)
+    : seg_(seg), mode_(mode) {}
+
+  // Calls f(uint32_t ring, ShmRecord kind, std::string_view payload) for every
+  // record available now.  payload points into the ring and is only valid
+  // during the call.  Returns the number of records.
+  // A ring whose head or record headers do not add up (a producer bug or
+  // crash mid-write) has its unread contents dropped and counted in errors();
+  // reading resumes with what the producer writes next.
+  template <typename F>
+  size_t poll(F&& f)
+  {
+    size_t n = 0;
+    uint32_t size = seg_.ring_bytes();
+    uint32_t mask = size - 1;
+    for (uint32_t i = 0; i < seg_.num_rings(); ++i) {
+      auto ring = seg_.ring(i);
+      char const* data = seg_.ring_data(i);
+      uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+      uint64_t head = ring->head.load(std::memory_order_acquire);
+      if (head - tail > size) tail = drop(head);
+      while (tail != head) {
+        shm::RecordHeader h;
+        uint32_t at = tail & mask;
+        if (head - tail < sizeof(h)) { tail = drop(head); break; }
+        std::memcpy(&h, data + at, sizeof(h));
+        uint64_t need = sizeof(h) + shm::align8(h.length);  // records never wrap
+        if (need > size - at || need > head - tail || !known(h.kind)) { tail = drop(head); break; }
+        if (h.kind != ShmRecord::Padding) {
+          f(i, h.kind, std::string_view(data + at + sizeof(h), h.length));
+          ++n;
+        }
+        tail += need;
+      }
+      ring->tail.store(tail, std::memory_order_release);
+    }
+    return n;
+  }
+
+  size_t errors() const { return errors_; }  // rings dropped by poll()
+
+  // Polls until stop becomes true, waiting as chosen by the WaitMode
+  template <typename F>
+  void run(F&& f, std::atomic<bool> const& stop)
+  {
+    auto h = seg_.header();
+    size_t idle = 0;
+    while (!stop.load(std::memory_order_relaxed)) {
+      if (poll(f)) { idle = 0; continue; }
+      if (mode_ == WaitMode::BusyPoll || ++idle < shm::IDLE_SPINS) {
+        shm::cpu_relax();
+        continue;
+      }
+
+      uint32_t seq = h->wake_seq.load(std::memory_order_acquire);
+      h->sleeping.store(1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);  // pairs with ShmProducer::wake
+      if (!poll(f))  // a producer may have published before seeing sleeping
+        shm::futex(&h->wake_seq, FUTEX_WAIT, seq);
+      h->sleeping.store(0, std::memory_order_relaxed);
+      idle = 0;
+    }
+  }
+
+  void wake() {  // e.g. from the thread setting stop
+    auto h = seg_.header();
+    h->wake_seq.fetch_add(1, std::memory_order_release);
+    shm::futex(&h->wake_seq, FUTEX_WAKE, 1);
+  }
+
+private:
+  static bool known(ShmRecord k) {
+    return k == ShmRecord::Text || k == ShmRecord::Binary ||
+           k == ShmRecord::Handle || k == ShmRecord::Padding;
+  }
+
+  uint64_t drop(uint64_t head) { ++errors_; return head; }
+
+  ShmSegment const& seg_;
+  WaitMode mode_;
+  size_t errors_ = 0;
+};
+
+}  // namespace FIX
+
+#endif
@@ -0,0 +1,117 @@
+// LogReader regression test: scan() must see exactly the frames frames()
+// sees, in any chunking, and must rethrow what f or decode throws.
+//
+//   g++ -std=c++17 -g -fsanitize=address,undefined -I.. log_reader_test.cpp -o log_reader_test -lpthread
+//   ./log_reader_test
+
+#include "../log_reader.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace FIX;
+
+static int failures = 0;
+
+#define EXPECT(c) \
+  do { if (!(c)) { std::printf("%s:%d: %s\n", __FILE__, __LINE__, #c); ++failures; } } while (0)
+
+static std::string frame(std::string const& body)
+{
+  std::string s = "8=FIX.4.4\x01" "9=" + std::to_string(body.size()) + "\x01" + body;
+  unsigned cs = 0;
+  for (unsigned char c : s) cs += c;
+  char t[8];
+  std::snprintf(t, sizeof(t), "10=%03u\x01", cs % 256);
+  return s + t;
+}
+
+struct Seq
+{
+  std::string seq;
+  bool decode(char const*& b, char const* e) {
+    seq = std::string(find_field(b, e, 34));
+    b = e;
+    if (seq == "throw") throw std::runtime_error("decode");
+    return true;
+  }
+};
+
+int main()
+{
+  // Outer messages carrying whole FIX messages in XmlData, long enough that
+  // chunk edges land inside them
+  std::mt19937 rng(1);
+  std::string log;
+  for (int i = 0; i < 3000; ++i) {
+    std::string body = "35=D\x01" "34=" + std::to_string(i) + "\x01";
+    if (rng() % 2) {
+      std::string inner;
+      for (int k = rng() % 4; k-- > 0;) inner += frame("35=8\x01" "34=inner\x01" "58=" + std::string(rng() % 300, 'z') + "\x01");
+      body += "212=" + std::to_string(inner.size()) + "\x01" "213=" + inner + "\x01";
+    }
+    log += frame(body);
+    if (rng() % 5 == 0) log += "\n";
+  }
+
+  char path[] = "/tmp/log_reader_testXXXXXX";
+  int fd = ::mkstemp(path);
+  EXPECT(fd >= 0 && ::write(fd, log.data(), log.size()) == ssize_t(log.size()));
+  ::close(fd);
+
+  {
+    LogReader reader(path);
+    LogFilter all;
+    std::vector<std::string> want;
+    reader.frames(all, [&](Frame const& f) { want.emplace_back(f.field(34)); });
+    EXPECT(want.size() == 3000);
+
+    for (unsigned threads : { 1u, 3u, 8u, 32u }) {
+      std::vector<std::string> got;
+      ScanStats st = reader.scan<Seq>(all, [&](Frame const&, Seq& m) { got.push_back(m.seq); },
+                                      Delivery::Ordered, threads);
+      EXPECT(got == want);
+      EXPECT(st.frames == want.size());
+
+      std::atomic<size_t> n(0);
+      st = reader.scan<Seq>(all, [&](Frame const&, Seq&) { ++n; }, Delivery::Unordered, threads);
+      EXPECT(n == want.size() && st.frames == want.size());
+    }
+
+    // f throwing, on this thread and on the workers
+    for (Delivery d : { Delivery::Ordered, Delivery::Unordered }) {
+      bool caught = false;
+      try {
+        std::atomic<int> calls(0);
+        reader.scan<Seq>(all, [&](Frame const&, Seq&) {
+          if (++calls == 100) throw std::runtime_error("f");
+        }, d, 4);
+      }
+      catch (std::runtime_error const& e) { caught = std::string(e.what()) == "f"; }
+      EXPECT(caught);
+    }
+  }
+
+  // Msg::decode throwing
+  std::string bad = log + frame("35=D\x01" "34=throw\x01");
+  fd = ::open(path, O_WRONLY | O_TRUNC);
+  EXPECT(fd >= 0 && ::write(fd, bad.data(), bad.size()) == ssize_t(bad.size()));
+  ::close(fd);
+  {
+    LogReader reader(path);
+    bool caught = false;
+    try { reader.scan<Seq>(LogFilter(), [](Frame const&, Seq&) {}, Delivery::Ordered, 4); }
+    catch (std::runtime_error const& e) { caught = std::string(e.what()) == "decode"; }
+    EXPECT(caught);
+  }
+  ::unlink(path);
+
+  if (failures) std::printf("%d failures\n", failures);
+  else std::printf("ok\n");
+  return failures != 0;
+}
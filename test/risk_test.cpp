@@ -0,0 +1,60 @@
+// RiskEngine regression test: orders that would corrupt the running exposure
+// are rejected, and release() gives back exactly what check() reserved.
+//
+//   g++ -std=c++17 -g -fsanitize=address,undefined -I.. risk_test.cpp -o risk_test
+//   ./risk_test
+
+#include "../risk.hpp"
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+using namespace FIX;
+
+static int failures = 0;
+
+#define EXPECT(c) \
+  do { if (!(c)) { std::printf("%s:%d: %s\n", __FILE__, __LINE__, #c); ++failures; } } while (0)
+
+int main()
+{
+  StandardRiskEngine risk;
+  InstrumentLimits l;
+  l.ref_price = 100; l.max_qty = 1000; l.max_exposure = 1e5;
+  InstrumentSlot& ins = risk.add_instrument("I", l);
+  AccountSlot& acc = risk.add_account("A", 1e5);
+
+  std::string sec = "I", account = "A";
+  RiskTicket t;
+  auto check = [&](double qty, double px, bool has_price, RiskTicket& t) {
+    RiskOrder o{&sec, &account, '1', qty, px, has_price, qty * px};
+    return risk.check(o, t);
+  };
+
+  // NaN would make every later exposure check pass; negatives free room
+  EXPECT(check(NAN, 100, true, t) == RiskResult::BadQtyOrPrice);
+  EXPECT(check(0, 100, true, t) == RiskResult::BadQtyOrPrice);
+  EXPECT(check(-500, 100, true, t) == RiskResult::BadQtyOrPrice);
+  EXPECT(check(10, NAN, true, t) == RiskResult::BadQtyOrPrice);
+  EXPECT(check(10, -100, true, t) == RiskResult::BadQtyOrPrice);
+  EXPECT(check(10, INFINITY, true, t) == RiskResult::BadQtyOrPrice);
+  EXPECT(!t);
+  EXPECT(ins.exposure == 0 && acc.used == 0);
+
+  // Market order valued at the reference price, released after it moved
+  EXPECT(check(500, 0, false, t) == RiskResult::Accept);
+  EXPECT(ins.exposure == 5e4 && acc.used == 5e4);
+  ins.ref_price = 300;
+  RiskTicket t2;
+  EXPECT(check(1000, 0, false, t2) == RiskResult::Exposure && !t2);
+  risk.release(t, 100);
+  EXPECT(ins.exposure == 4e4 && acc.used == 4e4 && t.qty == 400);
+  risk.release(t);
+  EXPECT(!t && ins.exposure == 0 && acc.used == 0);
+  risk.release(t);
+  EXPECT(ins.exposure == 0);
+
+  if (failures) std::printf("%d failures\n", failures);
+  else std::printf("ok\n");
+  return failures != 0;
+}
@@ -0,0 +1,85 @@
+// Shared-memory transport: ring ownership and record limits.
+//
+//   g++ -std=c++17 -g -fsanitize=address,undefined -I.. shm_transport_test.cpp -o shm_transport_test
+//   ./shm_transport_test
+
+#include "../shm_transport.hpp"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+
+using namespace FIX;
+
+static int failures = 0;
+
+#define EXPECT(c) \
+  do { if (!(c)) { std::printf("%s:%d: %s\n", __FILE__, __LINE__, #c); ++failures; } } while (0)
+
+int main()
+{
+  ShmSegment seg = ShmSegment::create_anonymous(2, 4096);
+  ShmGateway gw(seg);
+  std::vector<std::string> got;
+  auto collect = [&](uint32_t, ShmRecord, std::string_view m) { got.emplace_back(m); };
+
+  {
+    // Two producers in one process get different rings; a third finds none
+    ShmProducer a(seg), b(seg);
+    EXPECT(a.ring() != b.ring());
+    bool threw = false;
+    try { ShmProducer c(seg); } catch (std::runtime_error const&) { threw = true; }
+    EXPECT(threw);
+
+    // A record that can never fit throws; a full ring returns false
+    std::string big(a.max_record() + 1, 'x');
+    threw = false;
+    try { a.send(big); } catch (std::length_error const&) { threw = true; }
+    EXPECT(threw);
+    std::string half(a.max_record(), 'x');
+    EXPECT(a.send(half) && a.send(half));
+    EXPECT(!a.send(half));
+    gw.poll(collect);
+    EXPECT(got.size() == 2 && a.send(half));
+  }
+
+  // Rings held by children: freed on exit, and on a kill without detaching,
+  // even though the children share the segment's file description
+  for (int sig : { 0, SIGKILL }) {
+    int ready[2], go[2];
+    EXPECT(::pipe(ready) == 0 && ::pipe(go) == 0);
+    pid_t pid = ::fork();
+    if (pid == 0) {
+      ShmProducer p(seg);
+      ShmProducer q(seg);
+      p.send("from child");
+      char c = 1;
+      if (::write(ready[1], &c, 1) != 1) _exit(1);
+      ::close(go[1]);
+      while (::read(go[0], &c, 1) > 0) ;  // until the parent closes go, or kills us
+      _exit(0);  // no destructors: nothing detaches
+    }
+    char c;
+    EXPECT(::read(ready[0], &c, 1) == 1);
+    bool threw = false;
+    try { ShmProducer busy(seg); } catch (std::runtime_error const&) { threw = true; }
+    EXPECT(threw);
+    if (sig) ::kill(pid, sig);
+    ::close(go[1]);
+    ::waitpid(pid, nullptr, 0);
+    ::close(go[0]);
+    ::close(ready[0]);
+    ::close(ready[1]);
+
+    ShmProducer p(seg), q(seg);  // both rings free again
+    EXPECT(p.send("after"));
+  }
+  got.clear();
+  gw.poll(collect);
+  EXPECT(got.size() == 5 && gw.errors() == 0);
+
+  if (failures) std::printf("%d failures\n", failures);
+  else std::printf("ok\n");
+  return failures != 0;
+}
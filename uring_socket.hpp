@@ -0,0 +1,621 @@
+#ifndef FIX_URING_SOCKET_HPP_
+#define FIX_URING_SOCKET_HPP_
+
+// Socket backends for a connected FIX session, carrying Message::encode output.
+//
+// UringSocket  io_uring, straight on the kernel ABI (no liburing):
+//   - receive is one multishot recv fed from a provided buffer ring, so a
+//     single SQE keeps delivering; received buffers go to the Framer in place
+//     and are handed back to the kernel right after (kernels before 5.19,
+//     without buffer rings, get IORING_OP_PROVIDE_BUFFERS instead);
+//   - outgoing bytes are copied once into a send arena registered as a fixed
+//     buffer; one send is in flight at a time and everything queued behind it
+//     goes out in the next one, so bursts coalesce;
+//   - a send of at least zc_threshold bytes (resend bursts) uses
+//     IORING_OP_SEND_ZC from the fixed buffer, when the kernel has it.
+// EpollSocket  the fallback, non-blocking recv/send driven by epoll.
+//
+// Both have the same interface, so a session can take the backend as a
+// template parameter:
+//   bool send(char const* p, size_t n);   // false if the send queue is full
+//   int  poll(F&& on_frame, bool wait);   // frames delivered, -1 once closed
+//
+// Usage:
+//   // supported(): io_uring with multishot recv (6.0+), otherwise epoll
+//   if (UringSocket::supported()) run(UringSocket(fd)); else run(EpollSocket(fd));
+//   ...
+//   order.encode(buf);
+//   sock.send(buf.data(), buf.size());
+//   sock.poll([&](Frame const& f) { msg.decode(...); }, true);
+
+#include "frame.hpp"
+#include <cerrno>
+#include <deque>
+#include <stdexcept>  // std::runtime_error
+#include <vector>
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace FIX {
+
+struct UringConfig
+{
+  unsigned entries      = 64;         // SQ size
+  unsigned recv_buffers = 64;         // provided buffers, power of 2
+  unsigned recv_size    = 16 << 10;   // bytes each
+  unsigned send_slots   = 16;         // send arena is send_slots * send_slot_size
+  unsigned send_slot_size = 64 << 10; // largest single send()
+  unsigned zc_threshold = 16 << 10;   // sends this large use SEND_ZC
+};
+
+
+class Uring
+// Minimal io_uring: setup, SQE/CQE rings and register
+{
+public:
+  explicit Uring(unsigned entries, unsigned flags = 0)
+  {
+    io_uring_params p = {};
+    p.flags = flags;
+    fd_ = ::syscall(__NR_io_uring_setup, entries, &p);
+    if (fd_ < 0) throw std::runtime_error("io_uring_setup failed");
+    if (!(p.features & IORING_FEAT_SINGLE_MMAP)) {
+      ::close(fd_);
+      throw std::runtime_error("io_uring without IORING_FEAT_SINGLE_MMAP");
+    }
+
+    ring_sz_ = std::max(p.sq_off.array + p.sq_entries * sizeof(unsigned),
+                        p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe));
+    ring_ = map(ring_sz_, IORING_OFF_SQ_RING);
+    sqes_sz_ = p.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = static_cast<io_uring_sqe*>(map(sqes_sz_, IORING_OFF_SQES));
+
+    char* r = static_cast<char*>(ring_);
+    sq_head_  = reinterpret_cast<unsigned*>(r + p.sq_off.head);
+    sq_tail_  = reinterpret_cast<unsigned*>(r + p.sq_off.tail);
+    sq_mask_  = *reinterpret_cast<unsigned*>(r + p.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(r + p.sq_off.array);
+    cq_head_  = reinterpret_cast<unsigned*>(r + p.cq_off.head);
+    cq_tail_  = reinterpret_cast<unsigned*>(r + p.cq_off.tail);
+    cq_mask_  = *reinterpret_cast<unsigned*>(r + p.cq_off.ring_mask);
+    cqes_     = reinterpret_cast<io_uring_cqe*>(r + p.cq_off.cqes);
+    sq_entries_ = p.sq_entries;
+    local_tail_ = *sq_tail_;
+  }
+
+  ~Uring() {
+    if (sqes_) ::munmap(sqes_, sqes_sz_);
+    if (ring_) ::munmap(ring_, ring_sz_);
+    if (fd_ >= 0) ::close(fd_);
+  }
+
+  Uring(Uring const&) = delete;
+  Uring& operator=(Uring const&) = delete;
+
+  io_uring_sqe* sqe()  // zeroed; nullptr if the SQ is full
+  {
+    unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    if (local_tail_ - head >= sq_entries_) return nullptr;
+    unsigned i = local_tail_++ & sq_mask_;
+    sq_array_[i] = i;
+    io_uring_sqe* s = &sqes_[i];
+    std::memset(s, 0, sizeof(*s));
+    return s;
+  }
+
+  // Submits new SQEs and waits for wait_nr completions.  With get_events, an
+  // empty CQ also enters the kernel so deferred completion work gets run.
+  int submit(unsigned wait_nr = 0, bool get_events = false)
+  {
+    unsigned n = local_tail_ - *sq_tail_;
+    __atomic_store_n(sq_tail_, local_tail_, __ATOMIC_RELEASE);
+    bool events = wait_nr || (get_events && !ready());
+    if (!n && !events) return 0;
+    int r;
+    do {
+      r = ::syscall(__NR_io_uring_enter, fd_, n, wait_nr,
+                    events ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+    } while (r < 0 && errno == EINTR);
+    return r;
+  }
+
+  unsigned ready() const {  // completions waiting in the CQ
+    return __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE) - *cq_head_;
+  }
+
+  template <typename F>  // calls f(io_uring_cqe const&) for each completion
+  unsigned reap(F&& f)
+  {
+    unsigned head = *cq_head_, n = 0;
+    unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head, ++n) f(cqes_[head & cq_mask_]);
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    return n;
+  }
+
+  int reg(unsigned op, void* arg, unsigned nr) {
+    return ::syscall(__NR_io_uring_register, fd_, op, arg, nr);
+  }
+
+  bool supports(unsigned op)
+  {
+    enum { MAX_OPS = 256 };
+    std::vector<char> buf(sizeof(io_uring_probe) + MAX_OPS * sizeof(io_uring_probe_op));
+    auto probe = reinterpret_cast<io_uring_probe*>(buf.data());
+    if (reg(IORING_REGISTER_PROBE, probe, MAX_OPS) < 0 || op > probe->last_op) return false;
+    return probe->ops[op].flags & IO_URING_OP_SUPPORTED;
+  }
+
+private:
+  void* map(size_t sz, off_t off) {
+    void* p = ::mmap(nullptr, sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, off);
+    if (p == MAP_FAILED) {
+      if (ring_) ::munmap(ring_, ring_sz_);
+      ::close(fd_);
+      throw std::runtime_error("io_uring mmap failed");
+    }
+    return p;
+  }
+
+  int fd_ = -1;
+  void* ring_ = nullptr;
+  size_t ring_sz_ = 0;
+  io_uring_sqe* sqes_ = nullptr;
+  size_t sqes_sz_ = 0;
+  unsigned *sq_head_, *sq_tail_, *sq_array_, *cq_head_, *cq_tail_;
+  unsigned sq_mask_, cq_mask_, sq_entries_, local_tail_;
+  io_uring_cqe* cqes_;
+};
+
+
+class UringSocket
+{
+  enum : uint64_t { OP_RECV = 1, OP_SEND = 2, OP_PROVIDE = 3, OP_CANCEL = 4 };
+  enum : uint16_t { BUF_GROUP = 0, LEGACY_BUF_GROUP = 1 };
+  enum SlotState { Free, Filling, Queued, InFlight, Notify };
+
+  struct Slot
+  {
+    SlotState state = Free;
+    size_t size = 0, sent = 0;
+    bool zc = false;     // current send is SEND_ZC
+    unsigned notifs = 0; // SEND_ZC notifications still to come
+  };
+
+public:
+  // Everything the constructor relies on: RECV/SEND, provided buffers, and
+  // multishot recv (6.0+), which is tried for real on a socketpair since no
+  // probe reports it.  The buffer ring (5.19+) is optional, see setup_recv().
+  static bool supported() {
+    try {
+      Uring ring(4);
+      return ring.supports(IORING_OP_RECV) && ring.supports(IORING_OP_SEND) &&
+             ring.supports(IORING_OP_PROVIDE_BUFFERS) && multishot_recv_works(ring);
+    }
+    catch (std::runtime_error const&) { return false; }
+  }
+
+  explicit UringSocket(int fd, UringConfig const& cfg = UringConfig())
+    : fd_(fd), cfg_(cfg), ring_(cfg.entries), slots_(cfg.send_slots)
+  {
+    if (cfg_.recv_buffers & (cfg_.recv_buffers - 1))
+      throw std::invalid_argument("recv_buffers must be a power of 2");
+    zc_ = ring_.supports(IORING_OP_SEND_ZC);
+    setup_recv();
+    try { setup_send(); }
+    catch (...) { unmap(); throw; }
+    arm_recv();
+  }
+
+  ~UringSocket() {
+    cancel();  // the kernel must be done with bufs_ and the arena first
+    unmap();
+  }
+
+  UringSocket(UringSocket const&) = delete;
+  UringSocket& operator=(UringSocket const&) = delete;
+
+  // Copies into the registered send arena; goes out on the next poll()
+  bool send(char const* p, size_t n)
+  {
+    if (closed_ || n > cfg_.send_slot_size) return false;
+    Slot* s = filling_ != NONE ? &slots_[filling_] : nullptr;
+    if (!s || s->size + n > cfg_.send_slot_size) {
+      size_t next = last_ == NONE ? 0 : (last_ + 1) % slots_.size();
+      if (slots_[next].state != Free) return false;  // arena full: caller backs off
+      if (s) { s->state = Queued; queue_.push_back(filling_); }
+      filling_ = last_ = next;
+      s = &slots_[next];
+      s->state = Filling;
+      s->size = s->sent = 0;
+    }
+    std::memcpy(slot_data(filling_) + s->size, p, n);
+    s->size += n;
+    return true;
+  }
+
+  template <typename F>
+  int poll(F&& on_frame, bool wait = false)
+  {
+    if (closed_) return -1;
+    kick_send();
+    ring_.submit(wait ? 1 : 0, true);
+
+    int frames = 0;
+    ring_.reap([&](io_uring_cqe const& cqe) {
+      switch (cqe.user_data >> 32) {
+        case OP_RECV: frames += on_recv(cqe, on_frame); break;
+        case OP_SEND: on_send(cqe); break;
+      }
+    });
+    if (rearm_) arm_recv();
+    kick_send();
+    ring_.submit();
+    return closed_ ? -1 : frames;
+  }
+
+  bool idle() const { return in_flight_ == NONE && queue_.empty() && filling_ == NONE; }
+
+private:
+  enum : size_t { NONE = size_t(-1) };
+
+  void unmap()
+  {
+    if (bufs_) ::munmap(bufs_, buf_ring_sz_ + size_t(cfg_.recv_buffers) * cfg_.recv_size);
+    if (arena_) ::munmap(arena_, size_t(cfg_.send_slots) * cfg_.send_slot_size);
+    bufs_ = arena_ = nullptr;
+  }
+
+  // Cancels the multishot recv and the send in flight, and waits for their
+  // last completions.  SEND_ZC notifications are not waited for: the pages
+  // stay pinned by the buffer registration until the ring goes.
+  void cancel()
+  {
+    auto cancel_op = [&](uint64_t user_data) {
+      io_uring_sqe* s = ring_.sqe();
+      if (!s) {
+        ring_.submit();
+        s = ring_.sqe();
+      }
+      if (!s) return;
+      s->opcode = IORING_OP_ASYNC_CANCEL;
+      s->addr = user_data;
+      s->user_data = OP_CANCEL << 32;
+    };
+    if (recv_armed_) cancel_op(OP_RECV << 32);
+    if (in_flight_ != NONE) cancel_op((OP_SEND << 32) | in_flight_);
+
+    while (recv_armed_ || in_flight_ != NONE) {
+      if (ring_.submit(1, true) < 0) break;
+      ring_.reap([&](io_uring_cqe const& cqe) {
+        uint64_t op = cqe.user_data >> 32;
+        if (op == OP_RECV && !(cqe.flags & IORING_CQE_F_MORE)) recv_armed_ = false;
+        if (op == OP_SEND && !(cqe.flags & IORING_CQE_F_NOTIF)) in_flight_ = NONE;
+      });
+    }
+  }
+
+  static bool multishot_recv_works(Uring& ring)
+  {
+    int sv[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) < 0) return false;
+    char buf[8];
+    io_uring_sqe* s = ring.sqe();
+    s->opcode = IORING_OP_PROVIDE_BUFFERS;
+    s->fd = 1;
+    s->addr = reinterpret_cast<uint64_t>(buf);
+    s->len = sizeof(buf);
+    s->buf_group = LEGACY_BUF_GROUP;
+    s->user_data = OP_PROVIDE << 32;
+    s = ring.sqe();
+    s->opcode = IORING_OP_RECV;
+    s->fd = sv[0];
+    s->ioprio = IORING_RECV_MULTISHOT;  // older kernels fail the recv with -EINVAL
+    s->flags = IOSQE_BUFFER_SELECT;
+    s->buf_group = LEGACY_BUF_GROUP;
+    s->user_data = OP_RECV << 32;
+
+    bool ok = false, done = false;
+    if (::write(sv[1], "8", 1) == 1 && ring.submit(2, true) >= 0)
+      for (int tries = 0; !done && tries < 2; ++tries) {
+        ring.reap([&](io_uring_cqe const& cqe) {
+          if (cqe.user_data >> 32 != OP_RECV) return;
+          ok = cqe.res == 1;
+          done = true;
+        });
+        if (!done) ring.submit(1, true);
+      }
+    ::close(sv[0]);
+    ::close(sv[1]);
+    return ok;
+  }
+
+  char* recv_data(unsigned bid) const { return bufs_ + buf_ring_sz_ + size_t(bid) * cfg_.recv_size; }
+  char* slot_data(size_t i) const { return arena_ + i * cfg_.send_slot_size; }
+
+  void setup_recv()
+  {
+    // buffer ring and the buffers in one page-aligned mapping
+    buf_ring_sz_ = (cfg_.recv_buffers * sizeof(io_uring_buf) + 4095) & ~size_t(4095);
+    size_t sz = buf_ring_sz_ + size_t(cfg_.recv_buffers) * cfg_.recv_size;
+    void* p = ::mmap(nullptr, sz, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) throw std::runtime_error("Cannot allocate receive buffers");
+    bufs_ = static_cast<char*>(p);
+    buf_ring_ = static_cast<io_uring_buf_ring*>(p);
+
+    io_uring_buf_reg reg = {};
+    reg.ring_addr = reinterpret_cast<uint64_t>(buf_ring_);
+    reg.ring_entries = cfg_.recv_buffers;
+    reg.bgid = BUF_GROUP;
+    if (ring_.reg(IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {  // before 5.19
+      legacy_bufs_ = true;
+      provide(0, cfg_.recv_buffers);
+      return;
+    }
+    for (unsigned i = 0; i < cfg_.recv_buffers; ++i) recycle(i);
+  }
+
+  void setup_send()
+  {
+    size_t sz = size_t(cfg_.send_slots) * cfg_.send_slot_size;
+    void* p = ::mmap(nullptr, sz, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) throw std::runtime_error("Cannot allocate send arena");
+    arena_ = static_cast<char*>(p);
+
+    iovec iov = { arena_, sz };
+    if (ring_.reg(IORING_REGISTER_BUFFERS, &iov, 1) < 0) zc_ = false;  // SEND_ZC needs it
+  }
+
+  void recycle(unsigned bid)  // hands a receive buffer back to the kernel
+  {
+    if (legacy_bufs_) { provide(bid, 1); return; }
+    unsigned mask = cfg_.recv_buffers - 1;
+    io_uring_buf& b = buf_ring_->bufs[buf_tail_ & mask];
+    b.addr = reinterpret_cast<uint64_t>(recv_data(bid));
+    b.len = cfg_.recv_size;
+    b.bid = bid;
+    __atomic_store_n(&buf_ring_->tail, ++buf_tail_, __ATOMIC_RELEASE);
+  }
+
+  void provide(unsigned bid, unsigned n)  // IORING_OP_PROVIDE_BUFFERS
+  {
+    io_uring_sqe* s = ring_.sqe();
+    if (!s) {
+      ring_.submit();
+      s = ring_.sqe();
+    }
+    s->opcode = IORING_OP_PROVIDE_BUFFERS;
+    s->fd = n;
+    s->addr = reinterpret_cast<uint64_t>(recv_data(bid));
+    s->len = cfg_.recv_size;
+    s->off = bid;
+    s->buf_group = LEGACY_BUF_GROUP;
+    s->user_data = OP_PROVIDE << 32;
+  }
+
+  void arm_recv()
+  {
+    io_uring_sqe* s = ring_.sqe();
+    if (!s) { rearm_ = true; return; }
+    s->opcode = IORING_OP_RECV;
+    s->fd = fd_;
+    s->ioprio = IORING_RECV_MULTISHOT;
+    s->flags = IOSQE_BUFFER_SELECT;
+    s->buf_group = legacy_bufs_ ? LEGACY_BUF_GROUP : BUF_GROUP;
+    s->user_data = OP_RECV << 32;
+    rearm_ = false;
+    recv_armed_ = true;
+  }
+
+  template <typename F>
+  int on_recv(io_uring_cqe const& cqe, F& on_frame)
+  {
+    int frames = 0;
+    if (cqe.res > 0 && (cqe.flags & IORING_CQE_F_BUFFER)) {
+      unsigned bid = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+      char const* p = recv_data(bid);
+      ring_works_ = true;
+      framer_.feed(p, p + cqe.res, [&](Frame const& f) { ++frames; on_frame(f); });
+      recycle(bid);  // the Framer copied any partial tail
+    }
+    else if (cqe.res == -ENOBUFS && !ring_works_ && !legacy_bufs_) {
+      // Some kernels accept the ring registration but never select from it;
+      // fall back to classic provided buffers, all of which are free now.
+      legacy_bufs_ = true;
+      provide(0, cfg_.recv_buffers);
+    }
+    else if (cqe.res == 0 || (cqe.res < 0 && cqe.res != -ENOBUFS))
+      closed_ = true;  // EOF or error
+    if (!(cqe.flags & IORING_CQE_F_MORE)) {
+      recv_armed_ = false;
+      rearm_ = !closed_;
+    }
+    return frames;
+  }
+
+  void kick_send()
+  {
+    if (in_flight_ != NONE || closed_) return;
+    if (queue_.empty() && filling_ != NONE) {  // nothing queued: flush what is being filled
+      slots_[filling_].state = Queued;
+      queue_.push_back(filling_);
+      filling_ = NONE;
+    }
+    if (queue_.empty()) return;
+
+    io_uring_sqe* s = ring_.sqe();
+    if (!s) return;
+    size_t i = queue_.front();
+    queue_.pop_front();
+    Slot& slot = slots_[i];
+    slot.state = InFlight;
+    slot.zc = zc_ && slot.size - slot.sent >= cfg_.zc_threshold;
+
+    s->opcode = slot.zc ? IORING_OP_SEND_ZC : IORING_OP_SEND;
+    s->fd = fd_;
+    s->addr = reinterpret_cast<uint64_t>(slot_data(i) + slot.sent);
+    s->len = slot.size - slot.sent;
+    s->msg_flags = MSG_NOSIGNAL;
+    if (slot.zc) {
+      s->ioprio = IORING_RECVSEND_FIXED_BUF;
+      s->buf_index = 0;
+    }
+    s->user_data = (OP_SEND << 32) | i;
+    in_flight_ = i;
+  }
+
+  void on_send(io_uring_cqe const& cqe)
+  {
+    size_t i = cqe.user_data & 0xffffffff;
+    Slot& slot = slots_[i];
+
+    if (cqe.flags & IORING_CQE_F_NOTIF) {  // kernel is done with a SEND_ZC buffer
+      if (--slot.notifs == 0 && slot.state == Notify) slot.state = Free;
+      return;
+    }
+
+    in_flight_ = NONE;
+    if (slot.zc && (cqe.flags & IORING_CQE_F_MORE)) ++slot.notifs;  // always after the result
+    if (cqe.res < 0) {
+      if (slot.zc && (cqe.res == -EOPNOTSUPP || cqe.res == -EINVAL))
+        zc_ = false;  // e.g. AF_UNIX: nothing went out, resend it as a plain SEND
+      else if (cqe.res != -EAGAIN && cqe.res != -EINTR) { closed_ = true; return; }
+    }
+    else
+      slot.sent += cqe.res;
+
+    if (slot.sent < slot.size) {  // short send: the rest goes first, in order
+      slot.state = Queued;
+      queue_.push_front(i);
+    }
+    else  // the slot may only be refilled once the kernel lets go of its pages
+      slot.state = slot.notifs ? Notify : Free;
+  }
+
+  int fd_;
+  UringConfig cfg_;
+  Uring ring_;
+  bool zc_ = false;
+  bool closed_ = false;
+  bool rearm_ = false;
+  bool recv_armed_ = false;
+  bool ring_works_ = false;   // a buffer has come from the buffer ring
+  bool legacy_bufs_ = false;  // using IORING_OP_PROVIDE_BUFFERS instead
+
+  char* bufs_ = nullptr;
+  size_t buf_ring_sz_ = 0;
+  io_uring_buf_ring* buf_ring_ = nullptr;
+  uint16_t buf_tail_ = 0;
+  Framer framer_;
+
+  char* arena_ = nullptr;
+  std::vector<Slot> slots_;
+  std::deque<size_t> queue_;  // slots waiting to be sent, in order
+  size_t filling_ = NONE;
+  size_t last_ = NONE;        // most recently opened slot
+  size_t in_flight_ = NONE;
+};
+
+
+class EpollSocket
+// Fallback where io_uring is unavailable; same interface as UringSocket
+{
+public:
+  explicit EpollSocket(int fd, UringConfig const& cfg = UringConfig())
+    : fd_(fd), buf_(cfg.recv_size), max_queue_(size_t(cfg.send_slots) * cfg.send_slot_size)
+  {
+    ::fcntl(fd_, F_SETFL, ::fcntl(fd_, F_GETFL) | O_NONBLOCK);
+    ep_ = ::epoll_create1(EPOLL_CLOEXEC);
+    if (ep_ < 0) throw std::runtime_error("epoll_create1 failed");
+    epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.fd = fd_;
+    ::epoll_ctl(ep_, EPOLL_CTL_ADD, fd_, &ev);
+  }
+
+  ~EpollSocket() { ::close(ep_); }
+
+  EpollSocket(EpollSocket const&) = delete;
+  EpollSocket& operator=(EpollSocket const&) = delete;
+
+  bool send(char const* p, size_t n)
+  {
+    if (closed_ || out_.size() - out_pos_ + n > max_queue_) return false;
+    out_.append(p, n);
+    return true;
+  }
+
+  template <typename F>
+  int poll(F&& on_frame, bool wait = false)
+  {
+    if (closed_) return -1;
+    flush();
+
+    epoll_event ev;
+    int n = ::epoll_wait(ep_, &ev, 1, wait ? -1 : 0);
+    int frames = 0;
+    if (n > 0 && (ev.events & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+      for (;;) {
+        ssize_t r = ::recv(fd_, buf_.data(), buf_.size(), 0);
+        if (r > 0) {
+          framer_.feed(buf_.data(), buf_.data() + r, [&](Frame const& f) { ++frames; on_frame(f); });
+          continue;
+        }
+        if (r == 0 || (errno != EAGAIN && errno != EINTR)) closed_ = true;
+        if (r == 0 || errno != EINTR) break;
+      }
+    }
+    if (n > 0 && (ev.events & EPOLLOUT)) flush();
+    return closed_ ? -1 : frames;
+  }
+
+  bool idle() const { return out_pos_ == out_.size(); }
+
+private:
+  void flush()
+  {
+    while (out_pos_ < out_.size()) {
+      ssize_t r = ::send(fd_, out_.data() + out_pos_, out_.size() - out_pos_, MSG_NOSIGNAL);
+      if (r > 0) { out_pos_ += r; continue; }
+      if (r < 0 && errno == EINTR) continue;
+      if (r < 0 && errno != EAGAIN) closed_ = true;
+      break;
+    }
+    if (out_pos_ == out_.size()) { out_.clear(); out_pos_ = 0; }
+    else if (out_pos_ > out_.size() / 2) {  // steady backpressure: drop what was sent
+      out_.erase(0, out_pos_);
+      out_pos_ = 0;
+    }
+    watch_out(out_pos_ != out_.size());
+  }
+
+  void watch_out(bool on)
+  {
+    if (on == watching_out_) return;
+    epoll_event ev = {};
+    ev.events = EPOLLIN | (on ? uint32_t(EPOLLOUT) : 0u);
+    ev.data.fd = fd_;
+    ::epoll_ctl(ep_, EPOLL_CTL_MOD, fd_, &ev);
+    watching_out_ = on;
+  }
+
+  int fd_;
+  int ep_;
+  std::vector<char> buf_;
+  size_t max_queue_;
+  std::string out_;
+  size_t out_pos_ = 0;
+  bool watching_out_ = false;
+  bool closed_ = false;
+  Framer framer_;
+};
+
+}  // namespace FIX
+
+#endif
@@ -0,0 +1,258 @@
+#ifndef FIX_WIRE_HPP_
+#define FIX_WIRE_HPP_
+
+// Tag=value writer for Message::encode into a caller-supplied buffer.
+//
+// Each field has a compile-time upper bound on its encoded size: integers
+// and chars by their type, decimals by DECIMAL_DIGITS/DECIMAL_PLACES, and
+// strings and repeating groups by their declared capacity (DEF_CAPACITY).
+// A message whose fields are all bounded gets a constexpr max_size; given a
+// buffer that large, fields are written with no space checks at all.
+// Otherwise every field is checked against the space left.
+//
+// Values longer than their capacity, groups with more entries than theirs,
+// and decimals out of range are errors whatever the buffer size, so a
+// message encodes the same way into any buffer it fits.
+
+#include "field.hpp"
+#include <array>
+#include <charconv>    // std::to_chars
+#include <cmath>       // std::fabs
+#include <cstdint>
+#include <cstring>     // memcpy
+#include <stdexcept>   // std::length_error, std::range_error
+#include <string>
+#include <tuple>
+#include <utility>     // std::index_sequence
+
+namespace FIX {
+
+template <typename Field, typename... Fields> class Group;
+template <typename Field, typename... Fields> class RepeatGroup;
+
+enum { DECIMAL_DIGITS = 15, DECIMAL_PLACES = 8 };  // decimals: fixed point, rounded
+
+namespace wire {
+
+constexpr size_t UNBOUNDED = ~size_t(0);
+
+constexpr size_t digits(size_t n) { return n < 10 ? 1 : 1 + digits(n / 10); }
+
+constexpr double pow10(int n) { return n ? 10 * pow10(n - 1) : 1; }
+
+constexpr size_t bound_add(size_t a, size_t b) {
+  return a == UNBOUNDED || b == UNBOUNDED ? UNBOUNDED : a + b;
+}
+
+constexpr size_t bound_mul(size_t n, size_t a) {
+  return n == 0 || a == UNBOUNDED ? UNBOUNDED : n * a;  // n == 0: no capacity
+}
+
+template <uint tag_num>
+struct TagText
+// "tag=" as a constant
+{
+  static constexpr size_t size = digits(tag_num) + 1;
+
+  static constexpr std::array<char, size> make() {
+    std::array<char, size> t{};
+    t[size - 1] = '=';
+    for (size_t i = size - 1, n = tag_num; i-- > 0; n /= 10) t[i] = char('0' + n % 10);
+    return t;
+  }
+
+  static constexpr std::array<char, size> text = make();
+};
+
+//-----------------------------------------------------------------------------
+// Upper bound of a value, without tag and delimiter
+
+template <typename T, typename R, size_t cap> struct value_size { enum : size_t { value = UNBOUNDED }; };
+
+template <typename R, size_t cap> struct value_size<char, R, cap>  { enum : size_t { value = 1 }; };
+template <typename R, size_t cap> struct value_size<bool, R, cap>  { enum : size_t { value = 1 }; };
+template <typename R, size_t cap> struct value_size<int, R, cap>   { enum : size_t { value = 11 }; };
+template <typename R, size_t cap> struct value_size<uint, R, cap>  { enum : size_t { value = 10 }; };
+template <typename R, size_t cap> struct value_size<long, R, cap>  { enum : size_t { value = 20 }; };
+template <typename R, size_t cap> struct value_size<ulong, R, cap> { enum : size_t { value = 20 }; };
+
+template <typename R, size_t cap>
+struct value_size<double, R, cap>  // sign, one digit more on rounding up, point
+{
+  enum : size_t { value = 1 + DECIMAL_DIGITS + 1 + 1 + DECIMAL_PLACES };
+};
+
+template <typename R, size_t cap>
+struct value_size<std::string, R, cap> { enum : size_t { value = cap ? cap : UNBOUNDED }; };
+
+template <size_t cap>  // chars separated by spaces
+struct value_size<std::string, MultipleCharValueRules, cap> { enum : size_t { value = cap ? 2 * cap - 1 : UNBOUNDED }; };
+
+//-----------------------------------------------------------------------------
+// Upper bound of a whole field, of a group and of a tuple of fields
+
+template <typename F> struct max_size;
+
+template <typename Tuple> struct max_tuple_size;
+
+template <typename... Fs>
+struct max_tuple_size<std::tuple<Fs...>>
+{
+  static constexpr size_t sum() {
+    size_t s[] = { max_size<Fs>::value..., 0 };
+    size_t n = 0;
+    for (size_t x : s) n = bound_add(n, x);
+    return n;
+  }
+
+  static constexpr size_t value = sum();
+};
+
+template <uint tag_num, typename T, typename R>
+struct max_size<Field<tag_num, T, R>>
+{
+  static constexpr size_t value = bound_add(
+    TagText<tag_num>::size + 1,
+    value_size<T, R, capacity<Field<tag_num, T, R>>::value>::value);
+};
+
+template <typename F>
+struct max_size<Optional<F>> : max_size<F> {};
+
+template <typename NoField, typename... Fields>
+struct max_size<RepeatGroup<NoField, Fields...>>
+{
+  enum : size_t { cap = capacity<RepeatGroup<NoField, Fields...>>::value };
+
+  static constexpr size_t value = bound_add(
+    TagText<NoField::tag>::size + digits(cap) + 1,
+    bound_mul(cap, max_tuple_size<typename Group<Fields...>::type>::value));
+};
+
+//-----------------------------------------------------------------------------
+// Writers.  Checked: throw if the buffer ends before the field does;
+// otherwise the caller has made sure there is room for max_size.
+
+[[noreturn]] inline void buffer_full() {
+  throw std::length_error("FIX encode: buffer too small");
+}
+
+[[noreturn]] inline void over_capacity(uint tag) {
+  throw std::length_error("FIX encode: tag " + std::to_string(tag) + " over its capacity");
+}
+
+[[noreturn]] inline void out_of_range(uint tag) {
+  throw std::range_error("FIX encode: tag " + std::to_string(tag) + " out of range");
+}
+
+template <bool Checked>
+inline void put(char*& p, char* e, char const* s, size_t n) {
+  if (Checked && size_t(e - p) < n) buffer_full();
+  std::memcpy(p, s, n);
+  p += n;
+}
+
+template <bool Checked, size_t W, typename T>
+inline void put_number(char*& p, char* e, T v, uint tag) {
+  auto r = std::to_chars(p, Checked ? e : p + W, v);
+  if (r.ec != std::errc()) Checked ? buffer_full() : out_of_range(tag);
+  p = r.ptr;
+}
+
+template <bool Checked, size_t cap, typename T, typename R>
+inline void put_value(char*& p, char* e, T const& v, R, uint tag) {
+  if constexpr (std::is_same<T, char>::value) {
+    if (Checked && p == e) buffer_full();
+    *p++ = v;
+  }
+  else if constexpr (std::is_same<T, bool>::value) {
+    if (Checked && p == e) buffer_full();
+    *p++ = v ? 'Y' : 'N';
+  }
+  else if constexpr (std::is_same<T, double>::value) {
+    double a = std::fabs(v);
+    if (!(a < pow10(DECIMAL_DIGITS))) out_of_range(tag);  // NaN too
+    uint64_t ip = uint64_t(a);
+    uint64_t fp = uint64_t((a - ip) * pow10(DECIMAL_PLACES) + 0.5);
+    if (fp == uint64_t(pow10(DECIMAL_PLACES))) { ++ip; fp = 0; }
+
+    char t[value_size<T, R, cap>::value];
+    char* q = t;
+    if (v < 0 && (ip || fp)) *q++ = '-';
+    q = std::to_chars(q, t + sizeof(t), ip).ptr;
+    if (fp) {  // 1.50000000 -> 1.5
+      *q++ = '.';
+      for (int i = DECIMAL_PLACES; i-- > 0; fp /= 10) q[i] = char('0' + fp % 10);
+      q += DECIMAL_PLACES;
+      while (q[-1] == '0') --q;
+    }
+    put<Checked>(p, e, t, q - t);
+  }
+  else if constexpr (std::is_integral<T>::value)
+    put_number<Checked, value_size<T, R, cap>::value>(p, e, v, tag);
+  else if constexpr (std::is_same<R, MultipleCharValueRules>::value) {
+    if (cap && v.size() > cap) over_capacity(tag);
+    if (v.empty()) return;
+    if (Checked && size_t(e - p) < 2 * v.size() - 1) buffer_full();
+    for (size_t i = 0; i < v.size(); ++i) {
+      if (i) *p++ = ' ';
+      *p++ = v[i];
+    }
+  }
+  else if constexpr (std::is_same<T, std::string>::value) {
+    if (cap && v.size() > cap) over_capacity(tag);
+    put<Checked>(p, e, v.data(), v.size());
+  }
+  else {  // MultipleString: never bounded, so always checked
+    for (size_t i = 0; i < v.size(); ++i) {
+      if (i) put<true>(p, e, " ", 1);
+      put<true>(p, e, v[i].data(), v[i].size());
+    }
+  }
+}
+
+template <bool Checked, typename Tuple>
+void put_fields(Tuple const& fields, char*& p, char* e);
+
+template <bool Checked, uint tag_num, typename T, typename R>
+inline void put_field(Field<tag_num, T, R> const& f, char*& p, char* e) {
+  typedef TagText<tag_num> tag_text;
+  put<Checked>(p, e, tag_text::text.data(), tag_text::size);
+  put_value<Checked, capacity<Field<tag_num, T, R>>::value>(p, e, f.value(), R(), tag_num);
+  put<Checked>(p, e, "\x01", 1);
+}
+
+template <bool Checked, typename F>
+inline void put_field(Optional<F> const& f, char*& p, char* e) {
+  if (f) put_field<Checked>(*f, p, e);
+}
+
+template <bool Checked, typename NoField, typename... Fields>
+inline void put_field(RepeatGroup<NoField, Fields...> const& rg, char*& p, char* e) {
+  enum : size_t { cap = capacity<RepeatGroup<NoField, Fields...>>::value };
+  auto const& groups = rg.groups();
+  if (groups.empty()) return;
+  if (cap != 0 && groups.size() > cap) over_capacity(NoField::tag);
+
+  typedef TagText<NoField::tag> tag_text;
+  put<Checked>(p, e, tag_text::text.data(), tag_text::size);
+  put_number<Checked, digits(~uint(0))>(p, e, uint(groups.size()), NoField::tag);
+  put<Checked>(p, e, "\x01", 1);
+  for (auto const& g : groups) put_fields<Checked>(g.fields(), p, e);
+}
+
+template <bool Checked, typename Tuple, size_t... I>
+inline void put_fields(Tuple const& fields, char*& p, char* e, std::index_sequence<I...>) {
+  (put_field<Checked>(std::get<I>(fields), p, e), ...);
+}
+
+template <bool Checked, typename Tuple>
+inline void put_fields(Tuple const& fields, char*& p, char* e) {
+  put_fields<Checked>(fields, p, e, std::make_index_sequence<std::tuple_size<Tuple>::value>());
+}
+
+}  // namespace wire
+
+}  // namespace FIX
+
+#endif